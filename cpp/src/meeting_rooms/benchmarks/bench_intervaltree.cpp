@@ -0,0 +1,217 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+#include "../include/interval_tree.hpp"
+
+using namespace std::chrono;
+
+// Orders in which the benchmarked intervals are inserted
+enum InsertionOrder : int64_t
+{
+    Sorted,
+    Random,
+    Balanced,  // midpoint first, as the driver does
+    Clustered, // bursts of intervals starting at the same few times
+};
+
+template <typename IntervalType>
+IntervalType toInterval(int64_t value)
+{
+    if constexpr (std::is_integral_v<IntervalType>)
+        return static_cast<IntervalType>(value);
+    else
+        return IntervalType(minutes(value));
+}
+
+template <typename PayloadType>
+PayloadType toPayload(int64_t value)
+{
+    static constexpr std::string_view RoomNames[] = {"#M0", "#M1", "#M2", "#M3", "#M4", "#M5", "#M6", "#M7"};
+
+    if constexpr (std::is_integral_v<PayloadType>)
+        return static_cast<PayloadType>(value);
+    else
+        return RoomNames[value % std::size(RoomNames)];
+}
+
+void appendMidpoints(int64_t low, int64_t high, std::vector<int64_t> &out)
+{
+    if (low > high)
+        return;
+
+    auto mid = low + (high - low) / 2;
+    out.push_back(mid);
+
+    appendMidpoints(low, mid - 1, out);
+    appendMidpoints(mid + 1, high, out);
+}
+
+// Starts of size intervals, 30 units long, in the given insertion order
+std::vector<int64_t> generateStarts(int64_t size, InsertionOrder order)
+{
+    std::vector<int64_t> starts;
+    starts.reserve(static_cast<size_t>(size));
+
+    std::mt19937_64 gen(42);
+
+    switch (order)
+    {
+    case Sorted:
+        for (int64_t i = 0; i < size; i++)
+            starts.push_back(i);
+        break;
+
+    case Random:
+        for (int64_t i = 0; i < size; i++)
+            starts.push_back(i);
+        std::shuffle(starts.begin(), starts.end(), gen);
+        break;
+
+    case Balanced:
+        appendMidpoints(0, size - 1, starts);
+        break;
+
+    case Clustered:
+    {
+        // About 16 intervals share every start, the bursts arrive in random order
+        std::uniform_int_distribution<int64_t> cluster(0, std::max<int64_t>(size / 16, 1) - 1);
+        for (int64_t i = 0; i < size; i++)
+            starts.push_back(cluster(gen) * 16);
+        break;
+    }
+    }
+
+    return starts;
+}
+
+template <typename TreeType>
+typename TreeType::Data intervalAt(const std::vector<int64_t> &starts, size_t i)
+{
+    using IntervalType = typename TreeType::Interval;
+    using PayloadType = typename TreeType::Payload;
+
+    return {toInterval<IntervalType>(starts[i]), toInterval<IntervalType>(starts[i] + 30), toPayload<PayloadType>(static_cast<int64_t>(i))};
+}
+
+template <typename TreeType>
+std::unique_ptr<TreeType> buildTree(const std::vector<int64_t> &starts)
+{
+    auto tree = std::make_unique<TreeType>();
+
+    for (size_t i = 0; i < starts.size(); i++)
+        tree->insert(intervalAt<TreeType>(starts, i));
+
+    return tree;
+}
+
+template <typename TreeType>
+static void BM_Insert(benchmark::State &state)
+{
+    auto starts = generateStarts(state.range(0), static_cast<InsertionOrder>(state.range(1)));
+
+    for (auto _ : state)
+    {
+        auto tree = buildTree<TreeType>(starts);
+        benchmark::DoNotOptimize(tree.get());
+
+        // Freeing the tree is not measured
+        state.PauseTiming();
+        tree.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename TreeType>
+static void BM_OverlapQuery(benchmark::State &state)
+{
+    using IntervalType = typename TreeType::Interval;
+    using PayloadType = typename TreeType::Payload;
+
+    auto size = state.range(0);
+    auto tree = buildTree<TreeType>(generateStarts(size, static_cast<InsertionOrder>(state.range(1))));
+
+    std::mt19937_64 gen(7);
+    std::uniform_int_distribution<int64_t> queryStart(0, size);
+    size_t noOverlaps = 0;
+
+    for (auto _ : state)
+    {
+        auto low = queryStart(gen);
+
+        tree->forEachOverlapping(toInterval<IntervalType>(low), toInterval<IntervalType>(low + 30), [&](const IntervalType &, const IntervalType &, const PayloadType &)
+                                 { noOverlaps++; });
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["overlaps"] = benchmark::Counter(static_cast<double>(noOverlaps), benchmark::Counter::kAvgIterations);
+}
+
+template <typename TreeType>
+static void BM_IntervalsEndingBefore(benchmark::State &state)
+{
+    using IntervalType = typename TreeType::Interval;
+
+    auto size = state.range(0);
+    auto tree = buildTree<TreeType>(generateStarts(size, static_cast<InsertionOrder>(state.range(1))));
+
+    // About 1% of the intervals end before, as for an expiry pass
+    auto high = toInterval<IntervalType>(size / 100 + 30);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(tree->getIntervalsEndingBefore(high));
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename TreeType>
+static void BM_Remove(benchmark::State &state)
+{
+    auto starts = generateStarts(state.range(0), static_cast<InsertionOrder>(state.range(1)));
+
+    std::vector<size_t> removalOrder(starts.size());
+    for (size_t i = 0; i < removalOrder.size(); i++)
+        removalOrder[i] = i;
+
+    std::shuffle(removalOrder.begin(), removalOrder.end(), std::mt19937_64(3));
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto tree = buildTree<TreeType>(starts);
+        state.ResumeTiming();
+
+        for (auto i : removalOrder)
+            tree->remove(intervalAt<TreeType>(starts, i));
+
+        benchmark::DoNotOptimize(tree->isEmpty());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Sizes from 1e3 to 1e7 for every insertion order
+static void TreeArguments(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgNames({"size", "order"})->ArgsProduct({benchmark::CreateRange(1000, 10000000, 10), {Sorted, Random, Balanced, Clustered}})->Unit(benchmark::kMicrosecond);
+}
+
+using IntTree = IntervalTree<int, int>;
+using TimeTree = IntervalTree<sys_time<milliseconds>, std::string_view>;
+
+BENCHMARK_TEMPLATE(BM_Insert, IntTree)->Apply(TreeArguments);
+BENCHMARK_TEMPLATE(BM_Insert, TimeTree)->Apply(TreeArguments);
+
+BENCHMARK_TEMPLATE(BM_OverlapQuery, IntTree)->Apply(TreeArguments);
+BENCHMARK_TEMPLATE(BM_OverlapQuery, TimeTree)->Apply(TreeArguments);
+
+BENCHMARK_TEMPLATE(BM_IntervalsEndingBefore, IntTree)->Apply(TreeArguments);
+BENCHMARK_TEMPLATE(BM_IntervalsEndingBefore, TimeTree)->Apply(TreeArguments);
+
+BENCHMARK_TEMPLATE(BM_Remove, IntTree)->Apply(TreeArguments);
+BENCHMARK_TEMPLATE(BM_Remove, TimeTree)->Apply(TreeArguments);
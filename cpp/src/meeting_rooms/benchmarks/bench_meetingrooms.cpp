@@ -0,0 +1,191 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../include/meeting_rooms.h"
+
+using SnapshotScheduler = BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId, PooledNodes, SnapshotReads>>;
+using FlatScheduler = BasicMeetingRoomScheduler<FlatIntervalIndex<sys_time<milliseconds>, RoomId>>;
+using CompactFlatScheduler = BasicMeetingRoomScheduler<FlatIntervalIndex<MinuteTime, RoomId>>;
+
+// Shared by the threads of a multi-threaded benchmark, created and destroyed by thread 0 around the benchmark loop
+template <typename SchedulerType>
+std::unique_ptr<SchedulerType> sharedScheduler;
+
+template <typename SchedulerType>
+void setUpScheduler(benchmark::State &state)
+{
+    if (state.thread_index() != 0)
+        return;
+
+    sharedScheduler<SchedulerType> = std::make_unique<SchedulerType>();
+
+    for (int64_t i = 0; i < state.range(0); i++)
+        sharedScheduler<SchedulerType>->registerRoom({"#M" + std::to_string(i), static_cast<size_t>(i)});
+}
+
+template <typename SchedulerType>
+void tearDownScheduler(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+        sharedScheduler<SchedulerType>.reset();
+}
+
+// Slots of the threads interleave one minute apart from tomorrow on, 30 minute meetings overlap the 30 previous ones
+DateTimeSlot slotOf(benchmark::State &state, const sys_days &firstDay, int64_t i)
+{
+    return DateTimeSlot(firstDay + minutes(i * state.threads() + state.thread_index()), 30);
+}
+
+template <typename SchedulerType>
+static void BM_RequestAnyRoom(benchmark::State &state)
+{
+    setUpScheduler<SchedulerType>(state);
+
+    auto firstDay = floor<days>(system_clock::now()) + days(1);
+    int64_t i = 0, noBooked = 0;
+
+    for (auto _ : state)
+        noBooked += sharedScheduler<SchedulerType>->requestRoom(slotOf(state, firstDay, i++)).has_value();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["booked"] = benchmark::Counter(static_cast<double>(noBooked), benchmark::Counter::kAvgIterations);
+
+    tearDownScheduler<SchedulerType>(state);
+}
+
+template <typename SchedulerType>
+static void BM_RequestNamedRoom(benchmark::State &state)
+{
+    setUpScheduler<SchedulerType>(state);
+
+    std::vector<std::string> roomNames;
+    for (int64_t i = 0; i < state.range(0); i++)
+        roomNames.push_back("#M" + std::to_string(i));
+
+    auto firstDay = floor<days>(system_clock::now()) + days(1);
+    int64_t i = 0, noBooked = 0;
+
+    for (auto _ : state)
+    {
+        noBooked += sharedScheduler<SchedulerType>->requestRoom(roomNames[static_cast<size_t>(i) % roomNames.size()], slotOf(state, firstDay, i)).has_value();
+        i++;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["booked"] = benchmark::Counter(static_cast<double>(noBooked), benchmark::Counter::kAvgIterations);
+
+    tearDownScheduler<SchedulerType>(state);
+}
+
+template <typename SchedulerType>
+static void BM_RequestRoomsBatch(benchmark::State &state)
+{
+    setUpScheduler<SchedulerType>(state);
+
+    auto firstDay = floor<days>(system_clock::now()) + days(1);
+    int64_t i = 0;
+
+    std::vector<DateTimeSlot> batch(static_cast<size_t>(state.range(1)));
+
+    for (auto _ : state)
+    {
+        for (auto &slot : batch)
+            slot = slotOf(state, firstDay, i++);
+
+        benchmark::DoNotOptimize(sharedScheduler<SchedulerType>->requestRooms(batch));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+
+    tearDownScheduler<SchedulerType>(state);
+}
+
+// Registered rooms, and booking threads
+static void SchedulerArguments(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgName("rooms")->Arg(16)->Arg(1024)->ThreadRange(1, 8)->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_RequestAnyRoom, MeetingRoomScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestAnyRoom, SnapshotScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestAnyRoom, FlatScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestAnyRoom, CompactMeetingRoomScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestAnyRoom, CompactFlatScheduler)->Apply(SchedulerArguments);
+
+BENCHMARK_TEMPLATE(BM_RequestNamedRoom, MeetingRoomScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestNamedRoom, FlatScheduler)->Apply(SchedulerArguments);
+BENCHMARK_TEMPLATE(BM_RequestNamedRoom, CompactFlatScheduler)->Apply(SchedulerArguments);
+
+BENCHMARK_TEMPLATE(BM_RequestRoomsBatch, MeetingRoomScheduler)->ArgNames({"rooms", "batch"})->ArgsProduct({{16, 1024}, {8, 64, 512}})->ThreadRange(1, 8)->UseRealTime();
+
+// Cleanup throughput over weeks of simulated time, with a booking every 30 minutes in every room, expired one simulated hour at a time
+static void BM_ExpireSimulatedWeeks(benchmark::State &state)
+{
+    sys_time<milliseconds> start = floor<days>(system_clock::now()) + days(1);
+    auto end = start + weeks(state.range(1));
+
+    std::vector<MeetingRoomBooking> bookings;
+    for (auto time = start; time < end; time += minutes(30))
+    {
+        for (int64_t room = 0; room < state.range(0); room++)
+            bookings.push_back({static_cast<RoomId>(room), DateTimeSlot(time, 30)});
+    }
+
+    size_t noExpired = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto scheduler = std::make_unique<SimulatedMeetingRoomScheduler>(VirtualClock(start));
+
+        for (int64_t i = 0; i < state.range(0); i++)
+            scheduler->registerRoom({"#M" + std::to_string(i), static_cast<size_t>(i)});
+
+        scheduler->importBookings(bookings);
+        state.ResumeTiming();
+
+        for (auto time = start; time <= end; time += hours(1))
+            noExpired += scheduler->advanceClock(time);
+
+        state.PauseTiming();
+        scheduler.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(noExpired));
+}
+
+BENCHMARK(BM_ExpireSimulatedWeeks)->ArgNames({"rooms", "weeks"})->ArgsProduct({{16, 256}, {1, 4}})->Unit(benchmark::kMillisecond);
+
+static void BM_AvailabilityGrid(benchmark::State &state)
+{
+    sys_time<milliseconds> start = floor<days>(system_clock::now()) + days(1);
+    auto end = start + days(state.range(1));
+    auto noRooms = state.range(0);
+
+    // Half of the rooms booked in 45 minute meetings every hour
+    std::vector<MeetingRoomBooking> bookings;
+    for (auto time = start; time < end; time += hours(1))
+    {
+        for (int64_t room = 0; room < noRooms; room += 2)
+            bookings.push_back({static_cast<RoomId>(room), DateTimeSlot(time, 45)});
+    }
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    for (int64_t i = 0; i < noRooms; i++)
+        scheduler.registerRoom({"#M" + std::to_string(i), static_cast<size_t>(i)});
+
+    scheduler.importBookings(bookings);
+
+    std::vector<uint64_t> grid(noRooms * SimulatedMeetingRoomScheduler::gridRowWords(start, end, minutes(15)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(scheduler.availabilityGrid(start, end, minutes(15), grid, static_cast<unsigned int>(state.range(2))));
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(bookings.size()));
+}
+
+BENCHMARK(BM_AvailabilityGrid)->ArgNames({"rooms", "days", "threads"})->ArgsProduct({{64, 1024}, {1, 90}, {1, 4}})->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,37 @@
+#include <benchmark/benchmark.h>
+
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Results are written as JSON next to the console output unless --benchmark_out is given,
+// two such files can be compared with tools/compare.py of Google Benchmark
+int main(int argc, char *argv[])
+{
+    vector<char *> args(argv, argv + argc);
+
+    bool hasOutput = false;
+    for (string_view arg : args)
+        hasOutput = hasOutput || arg.starts_with("--benchmark_out=");
+
+    char defaultOutput[] = "--benchmark_out=meeting_rooms_benchmarks.json";
+    char defaultFormat[] = "--benchmark_out_format=json";
+
+    if (!hasOutput)
+    {
+        args.push_back(defaultOutput);
+        args.push_back(defaultFormat);
+    }
+
+    int noArgs = static_cast<int>(args.size());
+
+    ::benchmark::Initialize(&noArgs, args.data());
+    if (::benchmark::ReportUnrecognizedArguments(noArgs, args.data()))
+        return 1;
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+
+    return 0;
+}
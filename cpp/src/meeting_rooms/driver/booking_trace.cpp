@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "booking_trace.h"
+
+void write_trace(const std::string &path, uint32_t nr_rooms, int64_t base_time_ms, std::vector<TraceRecord> records)
+{
+    std::stable_sort(records.begin(), records.end(), [](const TraceRecord &a, const TraceRecord &b)
+                     { return a.issued_ns < b.issued_ns; });
+
+    TraceHeader header{};
+    std::memcpy(header.magic, TraceHeader::Magic, sizeof(header.magic));
+    header.version = 1;
+    header.nr_rooms = nr_rooms;
+    header.base_time_ms = base_time_ms;
+    header.nr_records = records.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+
+    if (!out)
+        throw std::runtime_error("cannot write trace " + path);
+}
+
+MappedTrace::MappedTrace(const std::string &path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open trace " + path);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("not a trace: " + path);
+    }
+
+    this->mapping_size = static_cast<size_t>(info.st_size);
+    this->mapping = ::mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (this->mapping == MAP_FAILED)
+    {
+        this->mapping = nullptr;
+        throw std::runtime_error("cannot map trace " + path);
+    }
+
+    // Records are streamed once, front to back
+    ::madvise(this->mapping, this->mapping_size, MADV_SEQUENTIAL);
+
+    this->header = static_cast<const TraceHeader *>(this->mapping);
+
+    auto nr_records = (this->mapping_size - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    if (std::memcmp(this->header->magic, TraceHeader::Magic, sizeof(TraceHeader::Magic)) != 0 || this->header->version != 1 || this->header->nr_records > nr_records)
+    {
+        ::munmap(this->mapping, this->mapping_size);
+        throw std::runtime_error("not a trace: " + path);
+    }
+
+    this->records = std::span<const TraceRecord>(reinterpret_cast<const TraceRecord *>(this->header + 1), this->header->nr_records);
+}
+
+MappedTrace::~MappedTrace()
+{
+    if (this->mapping != nullptr)
+        ::munmap(this->mapping, this->mapping_size);
+}
+
+WorkloadResult replay_trace(MeetingRoomScheduler &scheduler, const std::vector<std::string> &room_names, const MappedTrace &trace, size_t nr_threads, double speed)
+{
+    std::vector<WorkloadResult> thread_results(nr_threads);
+
+    auto start = steady_clock::now();
+
+    // Slots keep their distance to the start of the replay
+    auto base_time = time_point_cast<milliseconds>(system_clock::now());
+    auto records = trace.getRecords();
+
+    auto run = [&](size_t thread_index)
+    {
+        auto &result = thread_results[thread_index];
+
+        for (const auto &record : records)
+        {
+            if (record.client % nr_threads != thread_index || record.op >= NoWorkloadOps)
+                continue;
+
+            auto due = steady_clock::now();
+
+            if (speed > 0)
+            {
+                due = start + duration_cast<steady_clock::duration>(nanoseconds(record.issued_ns) / speed);
+
+                std::this_thread::sleep_until(due - microseconds(200));
+                while (steady_clock::now() < due)
+                    std::this_thread::yield();
+            }
+
+            auto op = static_cast<WorkloadOp>(record.op);
+            auto slot = DateTimeSlot(base_time + milliseconds(record.slot_start_ms), record.duration_minutes);
+            bool succeeded = false;
+
+            // Rooms beyond the registered ones are replayed as bookings of any room
+            bool named = record.room_id < room_names.size();
+
+            switch (op)
+            {
+            case WorkloadOp::BookAnyRoom:
+            case WorkloadOp::BookNamedRoom:
+                succeeded = (op == WorkloadOp::BookNamedRoom && named ? scheduler.requestRoom(room_names[record.room_id], slot) : scheduler.requestRoom(slot)).has_value();
+                break;
+
+            case WorkloadOp::Cancel:
+                succeeded = named && scheduler.cancelBooking(MeetingRoomBooking{record.room_id, slot});
+                break;
+
+            case WorkloadOp::Query:
+                succeeded = named && scheduler.isRoomAvailable(room_names[record.room_id], slot);
+                break;
+            }
+
+            auto op_index = static_cast<size_t>(op);
+
+            result.issued[op_index]++;
+            result.succeeded[op_index] += succeeded;
+            result.latency[op_index].add(steady_clock::now() - due);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t tn = 0; tn < nr_threads; tn++)
+        threads.emplace_back(run, tn);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    WorkloadResult total;
+    total.elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+    total.base_time_ms = base_time.time_since_epoch().count();
+
+    for (const auto &result : thread_results)
+    {
+        for (size_t op = 0; op < NoWorkloadOps; op++)
+        {
+            total.issued[op] += result.issued[op];
+            total.succeeded[op] += result.succeeded[op];
+            total.latency[op].merge(result.latency[op]);
+        }
+    }
+
+    return total;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "load_generator.h"
+#include "trace_format.h"
+
+// Sorts the records by issue time and writes them after a header, throws std::runtime_error on I/O errors
+void write_trace(const std::string &path, uint32_t nr_rooms, int64_t base_time_ms, std::vector<TraceRecord> records);
+
+// Read-only memory mapping of a trace file, throws std::runtime_error if the file cannot be mapped or is not a trace
+class MappedTrace
+{
+public:
+    explicit MappedTrace(const std::string &path);
+    ~MappedTrace();
+
+    MappedTrace(const MappedTrace &) = delete;
+    MappedTrace &operator=(const MappedTrace &) = delete;
+
+    const TraceHeader &getHeader() const { return *this->header; }
+    std::span<const TraceRecord> getRecords() const { return this->records; }
+
+protected:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    const TraceHeader *header = nullptr;
+    std::span<const TraceRecord> records;
+};
+
+// Streams the records back into the scheduler from nr_threads threads, a client's records going to thread client % nr_threads.
+// speed scales the recorded pacing (1 replays in recorded time, 10 ten times faster), 0 replays as fast as possible.
+// Slots are shifted by the time elapsed since the capture.
+WorkloadResult replay_trace(MeetingRoomScheduler &scheduler, const std::vector<std::string> &room_names, const MappedTrace &trace, size_t nr_threads, double speed);
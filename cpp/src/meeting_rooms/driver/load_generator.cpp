@@ -0,0 +1,200 @@
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#include "load_generator.h"
+
+ZipfDistribution::ZipfDistribution(size_t n, double exponent) : cdf(std::max<size_t>(n, 1))
+{
+    double sum = 0;
+    for (size_t rank = 0; rank < this->cdf.size(); rank++)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        this->cdf[rank] = sum;
+    }
+
+    for (auto &p : this->cdf)
+        p /= sum;
+}
+
+size_t ZipfDistribution::operator()(std::mt19937_64 &gen)
+{
+    auto rank = std::lower_bound(this->cdf.begin(), this->cdf.end(), this->uniform(gen)) - this->cdf.begin();
+    return std::min(static_cast<size_t>(rank), this->cdf.size() - 1);
+}
+
+const char *to_string(WorkloadOp op)
+{
+    switch (op)
+    {
+    case WorkloadOp::BookAnyRoom:
+        return "book any";
+    case WorkloadOp::BookNamedRoom:
+        return "book named";
+    case WorkloadOp::Cancel:
+        return "cancel";
+    case WorkloadOp::Query:
+        return "query";
+    }
+
+    return "";
+}
+
+// Random slots within the horizon, starting on 15 minutes boundaries from tomorrow on
+class SlotGenerator
+{
+public:
+    SlotGenerator(const WorkloadConfig &config) : first_day(floor<days>(system_clock::now()) + days(1)),
+                                                  day(0, static_cast<int>(std::max<size_t>(config.horizon_days, 1)) - 1),
+                                                  quarter_of_day(0, 24 * 4 - 1),
+                                                  // Centered on 13:00, about two thirds of the meetings fall between 11:00 and 15:00
+                                                  business_quarter(13 * 4, 2 * 4),
+                                                  distribution(config.slot_distribution), meeting_minutes(static_cast<unsigned>(config.meeting_minutes))
+    {
+    }
+
+    DateTimeSlot operator()(std::mt19937_64 &gen)
+    {
+        int quarter;
+
+        if (this->distribution == SlotDistribution::Uniform)
+            quarter = this->quarter_of_day(gen);
+        else
+            quarter = std::clamp(static_cast<int>(std::lround(this->business_quarter(gen))), 7 * 4, 19 * 4);
+
+        return DateTimeSlot(this->first_day + days(this->day(gen)) + minutes(15 * quarter), this->meeting_minutes);
+    }
+
+protected:
+    sys_days first_day;
+
+    std::uniform_int_distribution<int> day;
+    std::uniform_int_distribution<int> quarter_of_day;
+    std::normal_distribution<double> business_quarter;
+
+    SlotDistribution distribution;
+    unsigned meeting_minutes;
+};
+
+WorkloadResult run_workload(MeetingRoomScheduler &scheduler, const std::vector<std::string> &room_names, const WorkloadConfig &config)
+{
+    std::vector<WorkloadResult> thread_results(config.nr_threads);
+
+    auto interval = config.target_rate > 0 ? duration<double>(static_cast<double>(config.nr_threads) / config.target_rate) : duration<double>(0);
+    auto start = steady_clock::now();
+    auto base_time = time_point_cast<milliseconds>(system_clock::now());
+
+    auto run = [&](size_t thread_index)
+    {
+        auto &result = thread_results[thread_index];
+
+        std::mt19937_64 gen(config.seed + thread_index);
+        std::discrete_distribution<int> pick_op(config.op_mix.begin(), config.op_mix.end());
+        ZipfDistribution pick_room(room_names.size(), config.room_zipf_exponent);
+        SlotGenerator pick_slot(config);
+
+        // Bookings of this thread that may be cancelled
+        std::vector<MeetingRoomBooking> bookings;
+
+        for (size_t i = 0; i < config.nr_ops; i++)
+        {
+            auto due = steady_clock::now();
+
+            if (config.target_rate > 0)
+            {
+                due = start + duration_cast<steady_clock::duration>(interval * static_cast<double>(i));
+
+                // Sleeping overshoots by the timer slack, the last stretch is waited for by yielding
+                std::this_thread::sleep_until(due - microseconds(200));
+                while (steady_clock::now() < due)
+                    std::this_thread::yield();
+            }
+
+            auto op = static_cast<WorkloadOp>(pick_op(gen));
+            bool succeeded = false;
+
+            // Room and slot of the operation, kept for the trace
+            auto room_id = TraceRecord::AnyRoom;
+            DateTimeSlot slot;
+
+            switch (op)
+            {
+            case WorkloadOp::BookAnyRoom:
+            case WorkloadOp::BookNamedRoom:
+            {
+                slot = pick_slot(gen);
+
+                if (op == WorkloadOp::BookNamedRoom)
+                    room_id = static_cast<uint32_t>(pick_room(gen));
+
+                auto booking = op == WorkloadOp::BookAnyRoom ? scheduler.requestRoom(slot) : scheduler.requestRoom(room_names[room_id], slot);
+
+                succeeded = booking.has_value();
+                if (succeeded)
+                    bookings.push_back(booking.value());
+
+                break;
+            }
+            case WorkloadOp::Cancel:
+            {
+                if (bookings.empty())
+                    break;
+
+                auto pos = std::uniform_int_distribution<size_t>(0, bookings.size() - 1)(gen);
+                succeeded = scheduler.cancelBooking(bookings[pos]);
+
+                room_id = bookings[pos].roomId;
+                slot = bookings[pos].timeSlot;
+
+                bookings[pos] = bookings.back();
+                bookings.pop_back();
+
+                break;
+            }
+            case WorkloadOp::Query:
+                room_id = static_cast<uint32_t>(pick_room(gen));
+                slot = pick_slot(gen);
+
+                succeeded = scheduler.isRoomAvailable(room_names[room_id], slot);
+                break;
+            }
+
+            if (config.record_trace && (op != WorkloadOp::Cancel || succeeded))
+            {
+                result.trace.push_back(TraceRecord{duration_cast<nanoseconds>(due - start).count(), (slot.getStartTime() - base_time).count(), room_id,
+                                                   static_cast<uint16_t>(slot.getLength().count()), static_cast<uint8_t>(op), static_cast<uint8_t>(thread_index)});
+            }
+
+            auto op_index = static_cast<size_t>(op);
+
+            result.issued[op_index]++;
+            result.succeeded[op_index] += succeeded;
+            result.latency[op_index].add(steady_clock::now() - due);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t tn = 0; tn < config.nr_threads; tn++)
+        threads.emplace_back(run, tn);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    WorkloadResult total;
+    total.elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+    total.base_time_ms = base_time.time_since_epoch().count();
+
+    for (const auto &result : thread_results)
+    {
+        for (size_t op = 0; op < NoWorkloadOps; op++)
+        {
+            total.issued[op] += result.issued[op];
+            total.succeeded[op] += result.succeeded[op];
+            total.latency[op].merge(result.latency[op]);
+        }
+
+        total.trace.insert(total.trace.end(), result.trace.begin(), result.trace.end());
+    }
+
+    return total;
+}
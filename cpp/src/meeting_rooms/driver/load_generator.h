@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "../include/meeting_rooms.h"
+#include "trace_format.h"
+
+// Operations issued by the load generator, picked at random with the weights of the configured mix
+enum class WorkloadOp
+{
+    BookAnyRoom,
+    BookNamedRoom,
+    Cancel,
+    Query
+};
+
+constexpr size_t NoWorkloadOps = 4;
+
+// Start times of the requested slots: any time of the day, or clustered around the middle of the working day
+enum class SlotDistribution
+{
+    Uniform,
+    BusinessHours
+};
+
+struct WorkloadConfig
+{
+    size_t nr_threads = 1;
+    size_t nr_ops = 100000; // per thread
+
+    // Operations per second summed over all threads, 0 issues the next operation as soon as the previous one returns
+    double target_rate = 0;
+
+    // Weights of book any room, book by name, cancel and availability query
+    std::array<unsigned, NoWorkloadOps> op_mix = {60, 20, 10, 10};
+
+    SlotDistribution slot_distribution = SlotDistribution::BusinessHours;
+    size_t horizon_days = 30;
+    size_t meeting_minutes = 30;
+
+    // Exponent of the Zipfian distribution of rooms named by requests, 0 picks rooms uniformly
+    double room_zipf_exponent = 1.0;
+
+    uint64_t seed = 1;
+
+    // Keeps every issued operation in WorkloadResult::trace
+    bool record_trace = false;
+};
+
+struct WorkloadResult
+{
+    std::array<uint64_t, NoWorkloadOps> issued = {};
+    std::array<uint64_t, NoWorkloadOps> succeeded = {};
+
+    // Measured from the time an operation was due, so that a stalled scheduler also delays the operations behind it
+    std::array<LatencyHistogram, NoWorkloadOps> latency;
+
+    milliseconds elapsed{0};
+
+    // Recorded operations, unordered, and the system_clock time they are relative to
+    std::vector<TraceRecord> trace;
+    int64_t base_time_ms = 0;
+};
+
+// Ranks 0..n-1 with probabilities proportional to 1 / (rank + 1)^exponent
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(size_t n, double exponent);
+
+    size_t operator()(std::mt19937_64 &gen);
+
+protected:
+    std::vector<double> cdf;
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+};
+
+// Drives the scheduler from config.nr_threads threads, each running its own random stream of operations. With a target rate
+// operations are issued open loop at fixed intervals, whether or not the previous ones returned in time.
+WorkloadResult run_workload(MeetingRoomScheduler &scheduler, const std::vector<std::string> &room_names, const WorkloadConfig &config);
+
+const char *to_string(WorkloadOp op);
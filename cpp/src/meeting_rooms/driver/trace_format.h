@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary trace of scheduler operations: a TraceHeader followed by fixed size TraceRecords, in the byte order of the
+// machine that wrote it. Records are ordered by time, slots are stored relative to the capture start so that a
+// replay can move them next to its own start.
+struct TraceHeader
+{
+    static constexpr char Magic[8] = {'M', 'R', 'T', 'R', 'A', 'C', 'E', '1'};
+
+    char magic[8];
+    uint32_t version;
+    uint32_t nr_rooms;
+
+    // system_clock time of the capture start, in milliseconds since epoch
+    int64_t base_time_ms;
+    uint64_t nr_records;
+};
+
+struct TraceRecord
+{
+    static constexpr uint32_t AnyRoom = static_cast<uint32_t>(-1);
+
+    // Time the operation was issued, in nanoseconds since the capture start
+    int64_t issued_ns;
+
+    // Start of the requested, cancelled or queried slot, in milliseconds since base_time_ms
+    int64_t slot_start_ms;
+
+    uint32_t room_id; // AnyRoom for bookings of any room
+    uint16_t duration_minutes;
+    uint8_t op;       // WorkloadOp
+    uint8_t client;   // issuing thread, replays keep the order of the operations of a client
+};
+
+static_assert(sizeof(TraceHeader) == 32 && sizeof(TraceRecord) == 24, "Trace layout is part of the file format");
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <span>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+#include "meeting_rooms.h"
+
+enum class JournalOp : uint8_t
+{
+    Book,
+    Cancel
+};
+
+// Fixed size record of the journal, appended after the operation was applied to the index
+struct JournalRecord
+{
+    JournalOp op;
+    uint8_t reserved[3];
+    RoomId roomId;
+    int64_t startMs; // milliseconds since epoch
+    int64_t endMs;
+};
+
+static_assert(sizeof(JournalRecord) == 24 && std::is_trivially_copyable_v<JournalRecord>);
+
+// Fixed size record of a snapshot, a stored booking as written to disk
+struct SnapshotRecord
+{
+    RoomId roomId;
+    uint32_t reserved;
+    int64_t startMs; // milliseconds since epoch
+    int64_t endMs;
+};
+
+static_assert(sizeof(SnapshotRecord) == 24 && std::is_trivially_copyable_v<SnapshotRecord>);
+
+// Read-only memory mapping of a whole file, empty when the file does not exist.
+// Throws std::runtime_error if an existing file cannot be mapped.
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::span<const std::byte> getBytes() const { return {static_cast<const std::byte *>(this->mapping), this->mapping_size}; }
+
+protected:
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+// Append-only write-ahead journal of book and cancel operations. Callers append records under a short lock and wait
+// for them to be on disk; a flusher thread writes everything appended meanwhile with one fdatasync (group commit),
+// so that concurrent bookings share the cost of a sync instead of queueing for their own.
+class BookingJournal
+{
+public:
+    // Opens the journal for appending, creating it if needed. Throws std::system_error if it cannot be opened.
+    explicit BookingJournal(const std::string &a_path);
+
+    // Writes the records appended so far before closing
+    ~BookingJournal();
+
+    BookingJournal(const BookingJournal &) = delete;
+    BookingJournal &operator=(const BookingJournal &) = delete;
+
+    // Queues a record, returns its sequence number to wait for
+    uint64_t append(const JournalRecord &record);
+
+    // Blocks until the record of sequence number seq is on disk. Throws std::system_error if the journal could not be written.
+    void waitDurable(uint64_t seq);
+
+    void commit(const JournalRecord &record) { this->waitDurable(this->append(record)); }
+
+    // Moves the journal written so far to retiredPathOf(path) and continues in an empty one, for a snapshot to replace the retired records
+    void rotate();
+
+    const std::string &getPath() const { return this->path; }
+
+    // Journal moved aside by rotate(), replayed before the current one until the snapshot taken after the rotation is complete
+    static std::string retiredPathOf(const std::string &path) { return path + ".prev"; }
+
+    // Records of a journal file, a record torn by a crash at its end is dropped
+    static std::span<const JournalRecord> recordsOf(const MappedFile &file);
+
+protected:
+    std::string path;
+    int fd = -1;
+
+    // Held by the flusher while writing, so that rotate() swaps files between batches
+    std::mutex lck_file;
+
+    std::mutex lck_pending;
+    std::condition_variable cv_flush;
+    std::condition_variable cv_durable;
+
+    std::vector<JournalRecord> pending;
+    uint64_t appendedSeq = 0;
+    uint64_t durableSeq = 0;
+    int writeError = 0;
+    bool stop = false;
+
+    std::thread flusher;
+    void run_flusher();
+
+    // Moves the records of the journal to the end of an existing retired one, the caller holds lck_file
+    void appendTo(const std::string &retiredPath);
+};
+
+// Compact image of the stored bookings, written as SnapshotRecords after a header so that a mapped snapshot
+// is read in place
+class BookingSnapshot
+{
+public:
+    // Maps an existing snapshot, no records when there is none. Throws std::runtime_error if the file is not a snapshot.
+    explicit BookingSnapshot(const std::string &path);
+
+    std::span<const SnapshotRecord> getRecords() const { return this->records; }
+
+    // Writes and syncs a temporary file renamed over path, so that a crash leaves the previous snapshot intact.
+    // Throws std::system_error on I/O errors.
+    static void write(const std::string &path, std::span<const SnapshotRecord> records);
+
+protected:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t noBookings;
+    };
+
+    static constexpr char Magic[8] = {'M', 'R', 'S', 'N', 'A', 'P', '0', '1'};
+    static constexpr uint32_t Version = 2;
+
+    MappedFile file;
+    std::span<const SnapshotRecord> records;
+};
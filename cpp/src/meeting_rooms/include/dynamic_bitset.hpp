@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+
+// Growable bitset meant to be reused between queries, find-first-zero scans whole words at a time
+class DynamicBitset
+{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Clears all bits and sets the size, keeping the allocated words
+    void reset(size_t noBits)
+    {
+        this->size = noBits;
+        this->words.assign((noBits + WordBits - 1) / WordBits, 0);
+    }
+
+    size_t getSize() const { return this->size; }
+
+    void set(size_t pos)
+    {
+        this->words[pos / WordBits] |= Word(1) << (pos % WordBits);
+    }
+
+    bool test(size_t pos) const
+    {
+        return (this->words[pos / WordBits] >> (pos % WordBits)) & 1;
+    }
+
+    // Position of the first cleared bit at or after from, npos if every bit is set
+    size_t findFirstZero(size_t from = 0) const
+    {
+        if (from >= this->size)
+            return npos;
+
+        auto noWords = this->words.size();
+        auto wordIdx = from / WordBits;
+
+        // Bits before from in the first word count as set
+        auto word = this->words[wordIdx] | ((Word(1) << (from % WordBits)) - 1);
+
+        if (word == AllOnes)
+        {
+            wordIdx++;
+
+            // Four words are reduced at once so that the scan compiles to vector ANDs
+            while (wordIdx + 4 <= noWords && (this->words[wordIdx] & this->words[wordIdx + 1] & this->words[wordIdx + 2] & this->words[wordIdx + 3]) == AllOnes)
+                wordIdx += 4;
+
+            while (wordIdx < noWords && this->words[wordIdx] == AllOnes)
+                wordIdx++;
+
+            if (wordIdx == noWords)
+                return npos;
+
+            word = this->words[wordIdx];
+        }
+
+        auto pos = wordIdx * WordBits + std::countr_one(word);
+        return pos < this->size ? pos : npos;
+    }
+
+protected:
+    using Word = uint64_t;
+    static constexpr size_t WordBits = 64;
+    static constexpr Word AllOnes = ~Word(0);
+
+    std::vector<Word> words;
+    size_t size = 0;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+// Epoch based reclamation for structures read without locks. Readers announce themselves in a counter of the
+// current epoch parity, striped over cache line sized slots so that readers of different threads do not share a line.
+// A writer that unlinked nodes calls synchronize(), which waits for every reader that might still see them.
+class EpochReclamation
+{
+public:
+    struct Ticket
+    {
+        uint32_t slot;
+        uint32_t parity;
+    };
+
+    Ticket enter()
+    {
+        auto slot = threadSlot();
+        auto parity = static_cast<uint32_t>(this->epoch.load() & 1);
+
+        this->slots[slot].readers[parity].fetch_add(1);
+
+        return Ticket{slot, parity};
+    }
+
+    void exit(Ticket ticket)
+    {
+        this->slots[ticket.slot].readers[ticket.parity].fetch_sub(1, std::memory_order_release);
+    }
+
+    // Returns once every reader that might still see nodes unpublished before the call has exited.
+    // The root publish, the reader's announce and root load, and the scans below are all sequentially consistent:
+    // a reader missed by the scan of its counter announced itself after that scan, so it loads the new root.
+    // A reader may announce in either parity, having read the epoch long before, so both counters are scanned.
+    // The epoch is flipped before each scan so that new readers go to the other counter and the scanned one drains.
+    void synchronize()
+    {
+        for (int flip = 0; flip < 2; flip++)
+        {
+            auto parity = this->epoch.fetch_add(1) & 1;
+
+            for (auto &slot : this->slots)
+            {
+                while (slot.readers[parity].load() != 0)
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+protected:
+    static constexpr size_t NoSlots = 64;
+
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<int64_t> readers[2] = {0, 0};
+    };
+
+    std::array<ReaderSlot, NoSlots> slots;
+    std::atomic<uint64_t> epoch = 0;
+
+    static uint32_t threadSlot()
+    {
+        static std::atomic<uint32_t> nextSlot = 0;
+        thread_local uint32_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % NoSlots;
+
+        return slot;
+    }
+};
@@ -0,0 +1,908 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <shared_mutex>
+#include <optional>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <span>
+#include <list>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "interval_tree.hpp"
+#include "parallel_sort.hpp"
+
+// Maps interval end points to signed integers of the same ordering, which the flat index stores and compares in bulk
+template <typename IntervalType, typename Enable = void>
+struct FlatIndexKey;
+
+template <typename IntervalType>
+struct FlatIndexKey<IntervalType, std::enable_if_t<std::is_integral_v<IntervalType>>>
+{
+    using Raw = std::make_signed_t<IntervalType>;
+
+    // Unsigned values are shifted by the sign bit to keep their order as signed integers
+    static constexpr Raw Offset = std::is_signed_v<IntervalType> ? 0 : std::numeric_limits<Raw>::min();
+
+    static Raw encode(const IntervalType &value) { return static_cast<Raw>(value) ^ Offset; }
+    static IntervalType decode(Raw raw) { return static_cast<IntervalType>(raw ^ Offset); }
+};
+
+template <typename Clock, typename Duration>
+struct FlatIndexKey<std::chrono::time_point<Clock, Duration>, std::enable_if_t<std::is_integral_v<typename Duration::rep>>>
+{
+    using Raw = std::make_signed_t<typename Duration::rep>;
+
+    static Raw encode(const std::chrono::time_point<Clock, Duration> &value) { return value.time_since_epoch().count(); }
+    static std::chrono::time_point<Clock, Duration> decode(Raw raw) { return std::chrono::time_point<Clock, Duration>(Duration(raw)); }
+};
+
+// Interval index laid out as a B+ tree with wide nodes. Keys are stored structure-of-arrays style and inner nodes keep
+// the smallest key and the maximum high of each child, so one node is tested against a query with a few vector compares.
+// Offers the same interface as IntervalTree. Nodes emptied by removals are unlinked but partially filled ones are not merged.
+template <typename IntervalType, typename PayloadType, typename NodeMemoryResource = PooledNodes>
+class FlatIntervalIndex
+{
+public:
+    using Interval = IntervalType;
+    using Payload = PayloadType;
+
+    static constexpr uint32_t Fanout = 16;
+
+    FlatIntervalIndex() = default;
+    FlatIntervalIndex(const FlatIntervalIndex &) = delete;
+    FlatIntervalIndex &operator=(const FlatIntervalIndex &) = delete;
+
+    ~FlatIntervalIndex()
+    {
+        this->destroySubtree(this->root);
+    }
+
+    // Structure to hold data that clients will pass (low, high, <payload>)
+    struct Data
+    {
+        IntervalType low;
+        IntervalType high;
+
+        PayloadType payload;
+    };
+
+    void insert(Data iData)
+    {
+        std::unique_lock lock(this->rootSync);
+        this->insertRoot(iData);
+    }
+
+    void remove(Data iData)
+    {
+        std::unique_lock lock(this->rootSync);
+        this->removeRoot(iData);
+    }
+
+    // Inserts a batch of intervals under a single writer lock
+    void insertAll(std::span<const Data> batch)
+    {
+        std::unique_lock lock(this->rootSync);
+
+        for (const auto &iData : batch)
+            this->insertRoot(iData);
+    }
+
+    // Removes a batch of intervals under a single writer lock
+    void removeAll(std::span<const Data> batch)
+    {
+        std::unique_lock lock(this->rootSync);
+
+        for (const auto &iData : batch)
+            this->removeRoot(iData);
+    }
+
+    // Inserts a batch of intervals under a single writer lock by rebuilding the index: the batch is sorted, on several
+    // threads if asked to, merged with the stored intervals and packed into full nodes level by level
+    template <typename Range>
+    void bulkLoad(const Range &intervals, bool sortInParallel = false)
+    {
+        std::vector<Data> batch(std::begin(intervals), std::end(intervals));
+
+        auto isDataLess = [](const Data &a, const Data &b)
+        { return std::tie(a.low, a.high, a.payload) < std::tie(b.low, b.high, b.payload); };
+
+        if (sortInParallel)
+            parallelSort(batch.begin(), batch.end(), isDataLess);
+        else
+            std::sort(batch.begin(), batch.end(), isDataLess);
+
+        std::unique_lock lock(this->rootSync);
+
+        if (this->root != nullptr)
+        {
+            std::vector<Data> stored;
+            collectIntervals(this->root, stored);
+
+            std::vector<Data> merged;
+            merged.reserve(stored.size() + batch.size());
+            std::merge(stored.begin(), stored.end(), batch.begin(), batch.end(), std::back_inserter(merged), isDataLess);
+
+            batch.swap(merged);
+            this->destroySubtree(this->root);
+        }
+
+        // Equal intervals with equal payloads are stored once
+        batch.erase(std::unique(batch.begin(), batch.end(), [&](const Data &a, const Data &b)
+                                { return !isDataLess(a, b) && !isDataLess(b, a); }),
+                    batch.end());
+
+        this->buildPacked(batch);
+    }
+
+    // Removes every payload for which predicate(low, high, payload) holds in one pass under a single writer lock,
+    // returns the number of removed payloads
+    template <typename Predicate>
+    size_t removeIf(Predicate &&predicate)
+    {
+        std::unique_lock lock(this->rootSync);
+        return this->pruneRoot(predicate, std::numeric_limits<Raw>::max());
+    }
+
+    // Removes every interval ending at or before high, same as above
+    size_t removeEndingBefore(const IntervalType &high)
+    {
+        auto endsBefore = [&](const IntervalType &, const IntervalType &iHigh, const PayloadType &)
+        { return iHigh <= high; };
+
+        // Children starting after high cannot hold intervals ending before it
+        std::unique_lock lock(this->rootSync);
+        return this->pruneRoot(endsBefore, Key::encode(high));
+    }
+
+    // Inserts the interval only if no stored interval overlaps it, check and insert happen under one writer lock
+    bool tryInsertIfNoOverlap(Data iData)
+    {
+        std::unique_lock lock(this->rootSync);
+
+        if (this->findOverlap(this->root, Key::encode(iData.low), Key::encode(iData.high), std::nullopt))
+            return false;
+
+        this->insertRoot(iData);
+        return true;
+    }
+
+    // Same as above but only intervals holding the same payload are conflicts
+    bool tryInsertIfNoPayloadOverlap(Data iData)
+    {
+        std::unique_lock lock(this->rootSync);
+
+        if (this->findOverlap(this->root, Key::encode(iData.low), Key::encode(iData.high), iData.payload))
+            return false;
+
+        this->insertRoot(iData);
+        return true;
+    }
+
+    // Under one writer lock, calls visitor(low, high, payload) for every interval overlapping [low, high)
+    // and then inserts [low, high) with the payload returned by selector(), if it returns one
+    template <typename Visitor, typename Selector>
+    std::optional<PayloadType> tryInsertSelected(const IntervalType &low, const IntervalType &high, Visitor &&visitor, Selector &&selector)
+    {
+        std::unique_lock lock(this->rootSync);
+
+        this->visitOverlappingIntervals(this->root, Key::encode(low), Key::encode(high), visitor);
+
+        std::optional<PayloadType> payload = selector();
+        if (payload.has_value())
+            this->insertRoot(Data{low, high, payload.value()});
+
+        return payload;
+    }
+
+    std::list<Data> getOverlappingIntervalsWith(const IntervalType &low, const IntervalType &high)
+    {
+        std::list<Data> overlappingIntervals;
+
+        this->forEachOverlapping(low, high, [&](const IntervalType &iLow, const IntervalType &iHigh, const PayloadType &payload)
+                                 { overlappingIntervals.push_back(Data{iLow, iHigh, payload}); });
+
+        return overlappingIntervals;
+    }
+
+    std::list<Data> getIntervalsEndingBefore(const IntervalType &high)
+    {
+        std::list<Data> intervalsEndingBefore;
+
+        this->forEachEndingBefore(high, [&](const IntervalType &iLow, const IntervalType &iHigh, const PayloadType &payload)
+                                  { intervalsEndingBefore.push_back(Data{iLow, iHigh, payload}); });
+
+        return intervalsEndingBefore;
+    }
+
+    // Calls visitor(low, high, payload) for every stored interval overlapping [low, high), in ascending order.
+    // The visitor may return false to stop the search early, in which case false is returned.
+    template <typename Visitor>
+    bool forEachOverlapping(const IntervalType &low, const IntervalType &high, Visitor &&visitor)
+    {
+        std::shared_lock lock(this->rootSync);
+        return this->visitOverlappingIntervals(this->root, Key::encode(std::min(low, high)), Key::encode(std::max(low, high)), visitor);
+    }
+
+    // Calls visitor(low, high, payload) for every stored interval ending at or before high, with the same early exit as above
+    template <typename Visitor>
+    bool forEachEndingBefore(const IntervalType &high, Visitor &&visitor)
+    {
+        std::shared_lock lock(this->rootSync);
+        return this->visitIntervalsEndingBefore(this->root, Key::encode(high), visitor);
+    }
+
+    // Earliest start at or after from of a gap of length between the intervals holding payload, which may not overlap each other.
+    // Intervals are walked in start order, skipping the subtrees whose intervals all end at or before the candidate as it moves on.
+    template <typename Length>
+    IntervalType findGap(IntervalType from, const Length &length, const PayloadType &payload)
+    {
+        std::shared_lock lock(this->rootSync);
+        this->walkGap(this->root, from, length, payload);
+
+        return from;
+    }
+
+    // Checks if any interval (holding payload, when given) overlaps [low, high), returning at the first hit
+    bool anyOverlap(const IntervalType &low, const IntervalType &high, std::optional<PayloadType> payload = std::nullopt)
+    {
+        std::shared_lock lock(this->rootSync);
+        return this->findOverlap(this->root, Key::encode(std::min(low, high)), Key::encode(std::max(low, high)), payload);
+    }
+
+    bool isEmpty()
+    {
+        std::shared_lock lock(this->rootSync);
+        return this->root == nullptr;
+    }
+
+    // Number of node levels, 0 when empty
+    int getHeight()
+    {
+        std::shared_lock lock(this->rootSync);
+        return this->height;
+    }
+
+protected:
+    using Key = FlatIndexKey<IntervalType>;
+    using Raw = typename Key::Raw;
+
+    // Entries of a leaf, or for inner nodes the smallest entry below each child
+    struct Node
+    {
+        Raw lows[Fanout];
+        Raw highs[Fanout];
+        PayloadType payloads[Fanout];
+
+        uint32_t count;
+        bool isLeaf;
+    };
+
+    struct InnerNode : Node
+    {
+        Raw maxHighs[Fanout];
+        Node *children[Fanout];
+    };
+
+    using NodePtr = Node *;
+
+    NodeMemoryResource nodeMemory;
+
+    NodePtr root = nullptr;
+    int height = 0;
+    mutable std::shared_mutex rootSync;
+
+    static InnerNode *asInner(NodePtr node) { return static_cast<InnerNode *>(node); }
+
+    template <typename NodeType>
+    NodeType *createNode(bool isLeaf)
+    {
+        std::pmr::polymorphic_allocator<NodeType> allocator(&this->nodeMemory);
+
+        auto node = allocator.allocate(1);
+        std::construct_at(node);
+        node->count = 0;
+        node->isLeaf = isLeaf;
+
+        return node;
+    }
+
+    void destroyNode(NodePtr node)
+    {
+        if (node->isLeaf)
+        {
+            std::pmr::polymorphic_allocator<Node> allocator(&this->nodeMemory);
+            std::destroy_at(node);
+            allocator.deallocate(node, 1);
+        }
+        else
+        {
+            std::pmr::polymorphic_allocator<InnerNode> allocator(&this->nodeMemory);
+            std::destroy_at(asInner(node));
+            allocator.deallocate(asInner(node), 1);
+        }
+    }
+
+    void destroySubtree(NodePtr node)
+    {
+        if (node == nullptr)
+            return;
+
+        if (!node->isLeaf)
+        {
+            for (uint32_t i = 0; i < node->count; i++)
+                this->destroySubtree(asInner(node)->children[i]);
+        }
+
+        this->destroyNode(node);
+    }
+
+    // Appends the intervals of a subtree in key order
+    static void collectIntervals(NodePtr node, std::vector<Data> &out)
+    {
+        for (uint32_t i = 0; i < node->count; i++)
+        {
+            if (node->isLeaf)
+                out.push_back(Data{Key::decode(node->lows[i]), Key::decode(node->highs[i]), node->payloads[i]});
+            else
+                collectIntervals(asInner(node)->children[i], out);
+        }
+    }
+
+    // Replaces the (released) contents with full leaves holding the sorted intervals and the inner levels above them
+    void buildPacked(const std::vector<Data> &sorted)
+    {
+        this->root = nullptr;
+        this->height = 0;
+
+        if (sorted.empty())
+            return;
+
+        std::vector<NodePtr> level;
+        for (size_t first = 0; first < sorted.size(); first += Fanout)
+        {
+            auto leaf = this->createNode<Node>(true);
+            leaf->count = static_cast<uint32_t>(std::min<size_t>(Fanout, sorted.size() - first));
+
+            for (uint32_t i = 0; i < leaf->count; i++)
+            {
+                leaf->lows[i] = Key::encode(sorted[first + i].low);
+                leaf->highs[i] = Key::encode(sorted[first + i].high);
+                leaf->payloads[i] = sorted[first + i].payload;
+            }
+
+            level.push_back(leaf);
+        }
+
+        this->height = 1;
+
+        while (level.size() > 1)
+        {
+            std::vector<NodePtr> parents;
+            for (size_t first = 0; first < level.size(); first += Fanout)
+            {
+                auto inner = this->createNode<InnerNode>(false);
+                inner->count = static_cast<uint32_t>(std::min<size_t>(Fanout, level.size() - first));
+
+                for (uint32_t i = 0; i < inner->count; i++)
+                {
+                    inner->children[i] = level[first + i];
+                    updateChildSummary(inner, i);
+                }
+
+                parents.push_back(inner);
+            }
+
+            level.swap(parents);
+            this->height++;
+        }
+
+        this->root = level.front();
+    }
+
+    // Bit i is set for lanes with values[i] < bound
+    static uint32_t lessThanMask(const Raw *values, Raw bound)
+    {
+#if defined(__AVX2__)
+        if constexpr (sizeof(Raw) == 8)
+        {
+            auto boundVec = _mm256_set1_epi64x(bound);
+            uint32_t mask = 0;
+
+            for (uint32_t i = 0; i < Fanout; i += 4)
+            {
+                auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+                mask |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(boundVec, lanes)))) << i;
+            }
+
+            return mask;
+        }
+        else if constexpr (sizeof(Raw) == 4)
+        {
+            auto boundVec = _mm256_set1_epi32(bound);
+            uint32_t mask = 0;
+
+            for (uint32_t i = 0; i < Fanout; i += 8)
+            {
+                auto lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+                mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(boundVec, lanes)))) << i;
+            }
+
+            return mask;
+        }
+#elif defined(__SSE2__)
+        if constexpr (sizeof(Raw) == 4)
+        {
+            auto boundVec = _mm_set1_epi32(bound);
+            uint32_t mask = 0;
+
+            for (uint32_t i = 0; i < Fanout; i += 4)
+            {
+                auto lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+                mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(boundVec, lanes)))) << i;
+            }
+
+            return mask;
+        }
+#if defined(__SSE4_2__)
+        else if constexpr (sizeof(Raw) == 8)
+        {
+            auto boundVec = _mm_set1_epi64x(bound);
+            uint32_t mask = 0;
+
+            for (uint32_t i = 0; i < Fanout; i += 2)
+            {
+                auto lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+                mask |= static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(boundVec, lanes)))) << i;
+            }
+
+            return mask;
+        }
+#endif
+#endif
+        return scalarLessThanMask(values, bound);
+    }
+
+    // lessThanMask without vector instructions, for builds and key widths no vector path covers
+    static uint32_t scalarLessThanMask(const Raw *values, Raw bound)
+    {
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < Fanout; i++)
+            mask |= static_cast<uint32_t>(values[i] < bound) << i;
+
+        return mask;
+    }
+
+    // Bit i is set for lanes with values[i] > bound
+    static uint32_t greaterThanMask(const Raw *values, Raw bound)
+    {
+        // values[i] > bound is the complement of values[i] < bound + 1, bound + 1 cannot overflow for greater lanes to exist
+        if (bound == std::numeric_limits<Raw>::max())
+            return 0;
+
+        return ~lessThanMask(values, bound + 1) & ((uint32_t(1) << Fanout) - 1);
+    }
+
+    static uint32_t countMask(uint32_t count)
+    {
+        return count >= 32 ? ~uint32_t(0) : (uint32_t(1) << count) - 1;
+    }
+
+    // Lanes of a leaf overlapping [low, high), or children of an inner node that may hold such intervals
+    static uint32_t overlapMask(NodePtr node, Raw low, Raw high)
+    {
+        auto highs = node->isLeaf ? node->highs : asInner(node)->maxHighs;
+        return lessThanMask(node->lows, high) & greaterThanMask(highs, low) & countMask(node->count);
+    }
+
+    static bool isKeyLess(Raw lowA, Raw highA, const PayloadType &payloadA, Raw lowB, Raw highB, const PayloadType &payloadB)
+    {
+        return std::tie(lowA, highA, payloadA) < std::tie(lowB, highB, payloadB);
+    }
+
+    // First lane with a key greater or equal than the given one
+    static uint32_t lowerBound(NodePtr node, Raw low, Raw high, const PayloadType &payload)
+    {
+        uint32_t pos = 0;
+        while (pos < node->count && isKeyLess(node->lows[pos], node->highs[pos], node->payloads[pos], low, high, payload))
+            pos++;
+
+        return pos;
+    }
+
+    // Child of an inner node whose key range holds the given key
+    static uint32_t childFor(NodePtr node, Raw low, Raw high, const PayloadType &payload)
+    {
+        auto pos = lowerBound(node, low, high, payload);
+
+        if (pos < node->count && !isKeyLess(low, high, payload, node->lows[pos], node->highs[pos], node->payloads[pos]))
+            return pos;
+
+        return pos == 0 ? 0 : pos - 1;
+    }
+
+    static Raw maxHighOf(NodePtr node)
+    {
+        auto highs = node->isLeaf ? node->highs : asInner(node)->maxHighs;
+        return *std::max_element(highs, highs + node->count);
+    }
+
+    // Refreshes the summary (smallest key and maximum high) an inner node keeps for one of its children
+    static void updateChildSummary(InnerNode *node, uint32_t pos)
+    {
+        auto child = node->children[pos];
+
+        node->lows[pos] = child->lows[0];
+        node->highs[pos] = child->highs[0];
+        node->payloads[pos] = child->payloads[0];
+        node->maxHighs[pos] = maxHighOf(child);
+    }
+
+    static void shiftRight(NodePtr node, uint32_t pos)
+    {
+        std::copy_backward(node->lows + pos, node->lows + node->count, node->lows + node->count + 1);
+        std::copy_backward(node->highs + pos, node->highs + node->count, node->highs + node->count + 1);
+        std::copy_backward(node->payloads + pos, node->payloads + node->count, node->payloads + node->count + 1);
+
+        if (!node->isLeaf)
+        {
+            std::copy_backward(asInner(node)->maxHighs + pos, asInner(node)->maxHighs + node->count, asInner(node)->maxHighs + node->count + 1);
+            std::copy_backward(asInner(node)->children + pos, asInner(node)->children + node->count, asInner(node)->children + node->count + 1);
+        }
+
+        node->count++;
+    }
+
+    static void eraseLane(NodePtr node, uint32_t pos)
+    {
+        std::copy(node->lows + pos + 1, node->lows + node->count, node->lows + pos);
+        std::copy(node->highs + pos + 1, node->highs + node->count, node->highs + pos);
+        std::copy(node->payloads + pos + 1, node->payloads + node->count, node->payloads + pos);
+
+        if (!node->isLeaf)
+        {
+            std::copy(asInner(node)->maxHighs + pos + 1, asInner(node)->maxHighs + node->count, asInner(node)->maxHighs + pos);
+            std::copy(asInner(node)->children + pos + 1, asInner(node)->children + node->count, asInner(node)->children + pos);
+        }
+
+        node->count--;
+    }
+
+    // Moves the upper half of a full node to a new sibling and returns it
+    NodePtr split(NodePtr node)
+    {
+        NodePtr sibling = node->isLeaf ? static_cast<NodePtr>(this->createNode<Node>(true)) : this->createNode<InnerNode>(false);
+
+        auto half = node->count / 2;
+        sibling->count = node->count - half;
+
+        std::copy(node->lows + half, node->lows + node->count, sibling->lows);
+        std::copy(node->highs + half, node->highs + node->count, sibling->highs);
+        std::copy(node->payloads + half, node->payloads + node->count, sibling->payloads);
+
+        if (!node->isLeaf)
+        {
+            std::copy(asInner(node)->maxHighs + half, asInner(node)->maxHighs + node->count, asInner(sibling)->maxHighs);
+            std::copy(asInner(node)->children + half, asInner(node)->children + node->count, asInner(sibling)->children);
+        }
+
+        node->count = half;
+
+        return sibling;
+    }
+
+    // Inserts into the subtree, returns the new right sibling when the node had to split
+    NodePtr insertInternal(NodePtr node, Raw low, Raw high, const PayloadType &payload)
+    {
+        if (node->isLeaf)
+        {
+            auto pos = lowerBound(node, low, high, payload);
+
+            // Equal intervals with equal payloads are stored once
+            if (pos < node->count && node->lows[pos] == low && node->highs[pos] == high && node->payloads[pos] == payload)
+                return nullptr;
+
+            NodePtr sibling = nullptr;
+            if (node->count == Fanout)
+            {
+                sibling = this->split(node);
+
+                if (pos > node->count)
+                {
+                    pos -= node->count;
+                    node = sibling;
+                }
+            }
+
+            shiftRight(node, pos);
+            node->lows[pos] = low;
+            node->highs[pos] = high;
+            node->payloads[pos] = payload;
+
+            return sibling;
+        }
+
+        auto inner = asInner(node);
+        auto pos = childFor(node, low, high, payload);
+
+        auto childSibling = this->insertInternal(inner->children[pos], low, high, payload);
+        updateChildSummary(inner, pos);
+
+        if (childSibling == nullptr)
+            return nullptr;
+
+        NodePtr sibling = nullptr;
+        auto siblingPos = pos + 1;
+
+        if (node->count == Fanout)
+        {
+            sibling = this->split(node);
+
+            if (siblingPos > node->count)
+            {
+                siblingPos -= node->count;
+                inner = asInner(sibling);
+            }
+        }
+
+        shiftRight(inner, siblingPos);
+        inner->children[siblingPos] = childSibling;
+        updateChildSummary(inner, siblingPos);
+
+        return sibling;
+    }
+
+    void insertRoot(const Data &data)
+    {
+        auto low = Key::encode(data.low), high = Key::encode(data.high);
+
+        if (this->root == nullptr)
+        {
+            this->root = this->createNode<Node>(true);
+            this->height = 1;
+        }
+
+        auto sibling = this->insertInternal(this->root, low, high, data.payload);
+        if (sibling == nullptr)
+            return;
+
+        // The root split, the tree grows one level
+        auto newRoot = this->createNode<InnerNode>(false);
+        newRoot->count = 2;
+        newRoot->children[0] = this->root;
+        newRoot->children[1] = sibling;
+        updateChildSummary(newRoot, 0);
+        updateChildSummary(newRoot, 1);
+
+        this->root = newRoot;
+        this->height++;
+    }
+
+    // Removes the key from the subtree, returns true if it was found
+    bool removeInternal(NodePtr node, Raw low, Raw high, const PayloadType &payload)
+    {
+        if (node->isLeaf)
+        {
+            auto pos = lowerBound(node, low, high, payload);
+            if (pos == node->count || node->lows[pos] != low || node->highs[pos] != high || node->payloads[pos] != payload)
+                return false;
+
+            eraseLane(node, pos);
+            return true;
+        }
+
+        auto inner = asInner(node);
+        auto pos = childFor(node, low, high, payload);
+
+        if (!this->removeInternal(inner->children[pos], low, high, payload))
+            return false;
+
+        if (inner->children[pos]->count == 0)
+        {
+            this->destroyNode(inner->children[pos]);
+            eraseLane(node, pos);
+        }
+        else
+            updateChildSummary(inner, pos);
+
+        return true;
+    }
+
+    // Drops empty roots and inner roots with a single child
+    void shrinkRoot()
+    {
+        while (this->root != nullptr && (this->root->count == 0 || (!this->root->isLeaf && this->root->count == 1)))
+        {
+            auto oldRoot = this->root;
+
+            this->root = oldRoot->count == 0 ? nullptr : asInner(oldRoot)->children[0];
+            this->height--;
+
+            this->destroyNode(oldRoot);
+        }
+    }
+
+    void removeRoot(const Data &data)
+    {
+        if (this->root == nullptr)
+            return;
+
+        this->removeInternal(this->root, Key::encode(data.low), Key::encode(data.high), data.payload);
+        this->shrinkRoot();
+    }
+
+    // Removes matching lanes of the subtree in one pass, children with a smallest low above lowLimit are not visited
+    template <typename Predicate>
+    size_t pruneInternal(NodePtr node, Predicate &predicate, Raw lowLimit)
+    {
+        size_t noRemoved = 0;
+        uint32_t kept = 0;
+
+        for (uint32_t i = 0; i < node->count; i++)
+        {
+            bool keep;
+
+            if (node->lows[i] > lowLimit)
+                keep = true;
+            else if (node->isLeaf)
+                keep = !predicate(Key::decode(node->lows[i]), Key::decode(node->highs[i]), node->payloads[i]);
+            else
+            {
+                auto child = asInner(node)->children[i];
+                noRemoved += this->pruneInternal(child, predicate, lowLimit);
+
+                keep = child->count != 0;
+                if (keep)
+                    updateChildSummary(asInner(node), i);
+                else
+                    this->destroyNode(child);
+            }
+
+            if (!keep)
+            {
+                noRemoved += node->isLeaf;
+                continue;
+            }
+
+            node->lows[kept] = node->lows[i];
+            node->highs[kept] = node->highs[i];
+            node->payloads[kept] = node->payloads[i];
+
+            if (!node->isLeaf)
+            {
+                asInner(node)->maxHighs[kept] = asInner(node)->maxHighs[i];
+                asInner(node)->children[kept] = asInner(node)->children[i];
+            }
+
+            kept++;
+        }
+
+        node->count = kept;
+        return noRemoved;
+    }
+
+    template <typename Predicate>
+    size_t pruneRoot(Predicate &predicate, Raw lowLimit)
+    {
+        if (this->root == nullptr)
+            return 0;
+
+        auto noRemoved = this->pruneInternal(this->root, predicate, lowLimit);
+        this->shrinkRoot();
+
+        return noRemoved;
+    }
+
+    template <typename Visitor>
+    static bool visit(Visitor &visitor, NodePtr leaf, uint32_t pos)
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const IntervalType &, const IntervalType &, const PayloadType &>>)
+        {
+            visitor(Key::decode(leaf->lows[pos]), Key::decode(leaf->highs[pos]), leaf->payloads[pos]);
+            return true;
+        }
+        else
+            return visitor(Key::decode(leaf->lows[pos]), Key::decode(leaf->highs[pos]), leaf->payloads[pos]);
+    }
+
+    template <typename Visitor>
+    static bool visitOverlappingIntervals(NodePtr node, Raw low, Raw high, Visitor &visitor)
+    {
+        if (node == nullptr)
+            return true;
+
+        for (auto mask = overlapMask(node, low, high); mask != 0; mask &= mask - 1)
+        {
+            auto pos = static_cast<uint32_t>(std::countr_zero(mask));
+
+            if (node->isLeaf ? !visit(visitor, node, pos) : !visitOverlappingIntervals(asInner(node)->children[pos], low, high, visitor))
+                return false;
+        }
+
+        return true;
+    }
+
+    template <typename Visitor>
+    static bool visitIntervalsEndingBefore(NodePtr node, Raw high, Visitor &visitor)
+    {
+        if (node == nullptr)
+            return true;
+
+        // Intervals ending before high start at or before it
+        auto mask = ~greaterThanMask(node->lows, high) & countMask(node->count);
+
+        for (; mask != 0; mask &= mask - 1)
+        {
+            auto pos = static_cast<uint32_t>(std::countr_zero(mask));
+
+            if (node->isLeaf)
+            {
+                if (node->highs[pos] <= high && !visit(visitor, node, pos))
+                    return false;
+            }
+            else if (!visitIntervalsEndingBefore(asInner(node)->children[pos], high, visitor))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Moves from past the intervals holding payload that overlap [from, from + length), returns false once the gap is found
+    template <typename Length>
+    static bool walkGap(NodePtr node, IntervalType &from, const Length &length, const PayloadType &payload)
+    {
+        if (node == nullptr)
+            return true;
+
+        auto highs = node->isLeaf ? node->highs : asInner(node)->maxHighs;
+
+        for (auto mask = greaterThanMask(highs, Key::encode(from)) & countMask(node->count); mask != 0; mask &= mask - 1)
+        {
+            auto pos = static_cast<uint32_t>(std::countr_zero(mask));
+
+            // Lanes the candidate moved past since the mask was taken
+            if (highs[pos] <= Key::encode(from))
+                continue;
+
+            // This lane and the following ones start after the gap
+            if (node->lows[pos] >= Key::encode(from + length))
+                return false;
+
+            if (!node->isLeaf)
+            {
+                if (!walkGap(asInner(node)->children[pos], from, length, payload))
+                    return false;
+            }
+            else if (node->payloads[pos] == payload)
+                from = Key::decode(node->highs[pos]);
+        }
+
+        return true;
+    }
+
+    static bool findOverlap(NodePtr node, Raw low, Raw high, const std::optional<PayloadType> &payload)
+    {
+        if (node == nullptr)
+            return false;
+
+        for (auto mask = overlapMask(node, low, high); mask != 0; mask &= mask - 1)
+        {
+            auto pos = static_cast<uint32_t>(std::countr_zero(mask));
+
+            if (node->isLeaf ? (!payload.has_value() || node->payloads[pos] == payload.value()) : findOverlap(asInner(node)->children[pos], low, high, payload))
+                return true;
+        }
+
+        return false;
+    }
+};
@@ -1,16 +1,85 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <shared_mutex>
+#include <optional>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <span>
+#include <vector>
+#include <atomic>
 
 #include <set>
 #include <list>
 
-template <typename IntervalType, typename PayloadType>
+#include "epoch_reclamation.hpp"
+#include "parallel_sort.hpp"
+
+// Node memory policies of IntervalTree. The tree owns one instance of the resource and allocates
+// every node and payload set entry from it while holding the writer lock.
+
+// Slab/free-list pool: nodes released by remove are recycled by the next inserts
+using PooledNodes = std::pmr::unsynchronized_pool_resource;
+
+// One global heap allocation per node
+class HeapNodes : public std::pmr::memory_resource
+{
+protected:
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// Read policies of IntervalTree
+
+// Readers take a shared lock on the tree, writers update nodes in place under the unique lock
+struct LockedReads
+{
+    static constexpr bool CopyOnWrite = false;
+};
+
+// Writers copy the path they change and publish a new root, readers traverse an immutable snapshot
+// without locking. Replaced nodes are reclaimed once no reader can hold them anymore.
+struct SnapshotReads
+{
+    static constexpr bool CopyOnWrite = true;
+};
+
+// Interval tree implemented as an AVL tree keyed on (low, high) and augmented with the
+// maximum high value of each subtree, so that monotonic insertion orders keep it balanced
+template <typename IntervalType, typename PayloadType, typename NodeMemoryResource = PooledNodes, typename ReadPolicy = LockedReads>
 class IntervalTree
 {
 public:
+    using Interval = IntervalType;
+    using Payload = PayloadType;
+
+    IntervalTree() = default;
+    IntervalTree(const IntervalTree &) = delete;
+    IntervalTree &operator=(const IntervalTree &) = delete;
+
+    ~IntervalTree()
+    {
+        this->destroySubtree(this->root);
+
+        for (auto node : this->retiredNodes)
+            this->destroyNode(node);
+    }
+
     // Structure to hold data that clients will pass (low, high, <payload>)
     struct Data
     {
@@ -22,24 +91,147 @@ public:
 
     void insert(Data iData)
     {
-        std::unique_lock lock(this->rootSync);
+        WriteScope scope(*this);
         this->insertInternal(this->root, iData);
     }
 
     void remove(Data iData)
     {
-        std::unique_lock lock(this->rootSync);
+        WriteScope scope(*this);
         this->removeInternal(this->root, iData.low, iData.high, iData.payload);
     }
 
-    std::list<Data> getOverlappingIntervalsWith(const IntervalType &low, const IntervalType &high)
+    // Inserts a batch of intervals under a single writer lock
+    void insertAll(std::span<const Data> batch)
     {
-        std::list<Data> overlappingIntervals;
+        WriteScope scope(*this);
+
+        for (const auto &iData : batch)
+            this->insertInternal(this->root, iData);
+    }
+
+    // Removes a batch of intervals under a single writer lock
+    void removeAll(std::span<const Data> batch)
+    {
+        WriteScope scope(*this);
+
+        for (const auto &iData : batch)
+            this->removeInternal(this->root, iData.low, iData.high, iData.payload);
+    }
+
+    // Inserts a batch of intervals under a single writer lock by rebuilding the tree: the batch is sorted, on several
+    // threads if asked to, merged with the stored intervals and built bottom-up into a perfectly balanced tree.
+    // Equal (low, high) intervals share one node, as with insert.
+    template <typename Range>
+    void bulkLoad(const Range &intervals, bool sortInParallel = false)
+    {
+        std::vector<Data> batch(std::begin(intervals), std::end(intervals));
+
+        auto isDataLess = [](const Data &a, const Data &b)
+        { return isKeyLess(a.low, a.high, b.low, b.high); };
+
+        if (sortInParallel)
+            parallelSort(batch.begin(), batch.end(), isDataLess);
+        else
+            std::sort(batch.begin(), batch.end(), isDataLess);
 
+        WriteScope scope(*this);
+
+        if (this->root != nullptr)
+        {
+            std::vector<Data> stored;
+            this->collectIntervals(this->root, stored);
+
+            std::vector<Data> merged;
+            merged.reserve(stored.size() + batch.size());
+            std::merge(stored.begin(), stored.end(), batch.begin(), batch.end(), std::back_inserter(merged), isDataLess);
+
+            batch.swap(merged);
+            this->releaseSubtree(this->root);
+        }
+
+        // Start of every run of equal (low, high) intervals, each run becomes one node
+        std::vector<size_t> runs;
+        for (size_t i = 0; i < batch.size(); i++)
         {
-            std::shared_lock lock(this->rootSync);
-            this->searchOverlappingIntervals(this->root, std::min(low, high), std::max(low, high), overlappingIntervals);
+            if (i == 0 || batch[i].low != batch[i - 1].low || batch[i].high != batch[i - 1].high)
+                runs.push_back(i);
         }
+        runs.push_back(batch.size());
+
+        this->root = this->buildBalanced(batch, runs, 0, runs.size() - 1);
+    }
+
+    // Removes every payload for which predicate(low, high, payload) holds in one pass under a single writer lock,
+    // returns the number of removed payloads
+    template <typename Predicate>
+    size_t removeIf(Predicate &&predicate)
+    {
+        WriteScope scope(*this);
+        return this->pruneInternal(this->root, predicate, [](IntervalTreeNodePtr)
+                                   { return false; });
+    }
+
+    // Removes every interval ending at or before high, same as above
+    size_t removeEndingBefore(const IntervalType &high)
+    {
+        auto endsBefore = [&](const IntervalType &, const IntervalType &iHigh, const PayloadType &)
+        { return iHigh <= high; };
+
+        // A node starting after high and its right subtree cannot end before high
+        auto startsAfter = [&](IntervalTreeNodePtr node)
+        { return high < node->low; };
+
+        WriteScope scope(*this);
+        return this->pruneInternal(this->root, endsBefore, startsAfter);
+    }
+
+    // Inserts the interval only if no stored interval overlaps it, check and insert happen under one writer lock
+    bool tryInsertIfNoOverlap(Data iData)
+    {
+        WriteScope scope(*this);
+
+        if (this->findOverlap(this->root, iData.low, iData.high, std::nullopt))
+            return false;
+
+        this->insertInternal(this->root, iData);
+        return true;
+    }
+
+    // Same as above but only intervals holding the same payload are conflicts
+    bool tryInsertIfNoPayloadOverlap(Data iData)
+    {
+        WriteScope scope(*this);
+
+        if (this->findOverlap(this->root, iData.low, iData.high, iData.payload))
+            return false;
+
+        this->insertInternal(this->root, iData);
+        return true;
+    }
+
+    // Under one writer lock, calls visitor(low, high, payload) for every interval overlapping [low, high)
+    // and then inserts [low, high) with the payload returned by selector(), if it returns one
+    template <typename Visitor, typename Selector>
+    std::optional<PayloadType> tryInsertSelected(const IntervalType &low, const IntervalType &high, Visitor &&visitor, Selector &&selector)
+    {
+        WriteScope scope(*this);
+
+        this->visitOverlappingIntervals(this->root, low, high, visitor);
+
+        std::optional<PayloadType> payload = selector();
+        if (payload.has_value())
+            this->insertInternal(this->root, Data{low, high, payload.value()});
+
+        return payload;
+    }
+
+    std::list<Data> getOverlappingIntervalsWith(const IntervalType &low, const IntervalType &high)
+    {
+        std::list<Data> overlappingIntervals;
+
+        this->forEachOverlapping(low, high, [&](const IntervalType &iLow, const IntervalType &iHigh, const PayloadType &payload)
+                                 { overlappingIntervals.push_back(Data{iLow, iHigh, payload}); });
 
         return overlappingIntervals;
     }
@@ -48,66 +240,509 @@ public:
     {
         std::list<Data> intervalsEndingBefore;
 
-        {
-            std::shared_lock lock(this->rootSync);
-            this->searchIntervalsEndingBefore(this->root, high, intervalsEndingBefore);
-        }
+        this->forEachEndingBefore(high, [&](const IntervalType &iLow, const IntervalType &iHigh, const PayloadType &payload)
+                                  { intervalsEndingBefore.push_back(Data{iLow, iHigh, payload}); });
 
         return intervalsEndingBefore;
     }
 
+    // Calls visitor(low, high, payload) for every stored interval overlapping [low, high), in ascending order.
+    // The visitor may return false to stop the search early, in which case false is returned.
+    template <typename Visitor>
+    bool forEachOverlapping(const IntervalType &low, const IntervalType &high, Visitor &&visitor)
+    {
+        ReadScope scope(*this);
+        return this->visitOverlappingIntervals(scope.getRoot(), std::min(low, high), std::max(low, high), visitor);
+    }
+
+    // Calls visitor(low, high, payload) for every stored interval ending at or before high, with the same early exit as above
+    template <typename Visitor>
+    bool forEachEndingBefore(const IntervalType &high, Visitor &&visitor)
+    {
+        ReadScope scope(*this);
+        return this->visitIntervalsEndingBefore(scope.getRoot(), high, visitor);
+    }
+
+    // Earliest start at or after from of a gap of length between the intervals holding payload, which may not overlap each other.
+    // Intervals are walked in start order, skipping the subtrees whose intervals all end at or before the candidate as it moves on.
+    template <typename Length>
+    IntervalType findGap(IntervalType from, const Length &length, const PayloadType &payload)
+    {
+        ReadScope scope(*this);
+        this->walkGap(scope.getRoot(), from, length, payload);
+
+        return from;
+    }
+
+    // Checks if any interval (holding payload, when given) overlaps [low, high), returning at the first hit
+    bool anyOverlap(const IntervalType &low, const IntervalType &high, std::optional<PayloadType> payload = std::nullopt)
+    {
+        ReadScope scope(*this);
+        return this->findOverlap(scope.getRoot(), std::min(low, high), std::max(low, high), payload);
+    }
+
     bool isEmpty()
     {
-        std::unique_lock lock(this->rootSync);
-        auto empty = this->root == nullptr;
+        ReadScope scope(*this);
+        return scope.getRoot() == nullptr;
+    }
 
-        return empty;
+    // Height of the tree, 0 when empty
+    int getHeight()
+    {
+        ReadScope scope(*this);
+        return heightOf(scope.getRoot());
     }
 
 protected:
+    struct NoVersion
+    {
+    };
+
+    struct NoEpochs
+    {
+    };
+
+    // Write operation that created a node, only tracked for copy-on-write trees
+    using NodeVersion = std::conditional_t<ReadPolicy::CopyOnWrite, uint64_t, NoVersion>;
+
     // The interval node type in the interval tree
     struct IntervalTreeNode
     {
         // Merges payloads of equal (low, high) intervals
-        std::set<PayloadType> payloads;
+        std::pmr::set<PayloadType> payloads;
 
         IntervalType maxHigh;
         IntervalType low;
         IntervalType high;
 
-        std::unique_ptr<IntervalTreeNode> left;
-        std::unique_ptr<IntervalTreeNode> right;
+        // Height of the subtree rooted in this node (leaf = 1)
+        int height;
+
+        IntervalTreeNode *left;
+        IntervalTreeNode *right;
+
+        [[no_unique_address]] NodeVersion version;
     };
 
-    using IntervalTreeNodePtr = std::unique_ptr<IntervalTreeNode>;
+    // Nodes are owned by the tree and live in nodeMemory
+    using IntervalTreeNodePtr = IntervalTreeNode *;
 
-    IntervalTreeNodePtr root;
+    NodeMemoryResource nodeMemory;
+
+    // Root seen by writers, under rootSync
+    IntervalTreeNodePtr root = nullptr;
     mutable std::shared_mutex rootSync;
 
+    // Copy-on-write state: root published to readers, replaced nodes waiting for reclamation
+    // and the version of the write operation in progress
+    std::atomic<IntervalTreeNodePtr> snapshotRoot = nullptr;
+    std::vector<IntervalTreeNodePtr> retiredNodes;
+    uint64_t writeVersion = 0;
+    [[no_unique_address]] std::conditional_t<ReadPolicy::CopyOnWrite, EpochReclamation, NoEpochs> readerEpochs;
+
+    // Replaced nodes are reclaimed in batches, each batch waits for the readers once
+    static constexpr size_t ReclaimBatchSize = 1024;
+
+    // Holds the writer lock for the duration of a write operation and publishes the new root at its end
+    class WriteScope
+    {
+    public:
+        explicit WriteScope(IntervalTree &a_tree) : tree(a_tree), lock(a_tree.rootSync)
+        {
+            if constexpr (ReadPolicy::CopyOnWrite)
+                this->tree.writeVersion++;
+        }
+
+        ~WriteScope()
+        {
+            if constexpr (ReadPolicy::CopyOnWrite)
+            {
+                this->tree.snapshotRoot.store(this->tree.root);
+
+                if (this->tree.retiredNodes.size() >= ReclaimBatchSize)
+                    this->tree.reclaimRetiredNodes();
+            }
+        }
+
+    protected:
+        IntervalTree &tree;
+        std::unique_lock<std::shared_mutex> lock;
+    };
+
+    // Pins the tree for a query: a shared lock, or an epoch ticket and the published snapshot
+    class ReadScope
+    {
+    public:
+        explicit ReadScope(IntervalTree &a_tree) : tree(a_tree)
+        {
+            if constexpr (ReadPolicy::CopyOnWrite)
+            {
+                this->ticket = this->tree.readerEpochs.enter();
+                this->root = this->tree.snapshotRoot.load();
+            }
+            else
+            {
+                this->tree.rootSync.lock_shared();
+                this->root = this->tree.root;
+            }
+        }
+
+        ~ReadScope()
+        {
+            if constexpr (ReadPolicy::CopyOnWrite)
+                this->tree.readerEpochs.exit(this->ticket);
+            else
+                this->tree.rootSync.unlock_shared();
+        }
+
+        IntervalTreeNodePtr getRoot() const { return this->root; }
+
+    protected:
+        IntervalTree &tree;
+        IntervalTreeNodePtr root;
+        EpochReclamation::Ticket ticket;
+    };
+
+    NodeVersion currentVersion() const
+    {
+        if constexpr (ReadPolicy::CopyOnWrite)
+            return this->writeVersion;
+        else
+            return NoVersion{};
+    }
+
+    IntervalTreeNodePtr allocateNode(IntervalTreeNode &&content)
+    {
+        std::pmr::polymorphic_allocator<IntervalTreeNode> allocator(&this->nodeMemory);
+
+        auto node = allocator.allocate(1);
+        std::construct_at(node, std::move(content));
+
+        return node;
+    }
+
+    IntervalTreeNodePtr createNode(const IntervalType &low, const IntervalType &high, const PayloadType &payload)
+    {
+        return this->allocateNode(IntervalTreeNode{std::pmr::set<PayloadType>({payload}, &this->nodeMemory), high, low, high, 1, nullptr, nullptr, this->currentVersion()});
+    }
+
+    void destroyNode(IntervalTreeNodePtr node)
+    {
+        std::pmr::polymorphic_allocator<IntervalTreeNode> allocator(&this->nodeMemory);
+
+        std::destroy_at(node);
+        allocator.deallocate(node, 1);
+    }
+
+    void destroySubtree(IntervalTreeNodePtr node)
+    {
+        if (node == nullptr)
+            return;
+
+        this->destroySubtree(node->left);
+        this->destroySubtree(node->right);
+        this->destroyNode(node);
+    }
+
+    // Returns a node that the current write operation may modify. Copy-on-write trees copy nodes that
+    // readers might see and retire the original, every other node is returned as is.
+    IntervalTreeNodePtr writable(IntervalTreeNodePtr node)
+    {
+        if constexpr (ReadPolicy::CopyOnWrite)
+        {
+            if (node != nullptr && node->version != this->writeVersion)
+            {
+                auto copy = this->allocateNode(IntervalTreeNode{std::pmr::set<PayloadType>(node->payloads, &this->nodeMemory), node->maxHigh, node->low, node->high,
+                                                                node->height, node->left, node->right, this->writeVersion});
+
+                this->retiredNodes.push_back(node);
+                return copy;
+            }
+        }
+
+        return node;
+    }
+
+    // Frees a node unlinked by the current write operation, or retires it while readers might still see it
+    void releaseNode(IntervalTreeNodePtr node)
+    {
+        if constexpr (ReadPolicy::CopyOnWrite)
+        {
+            if (node->version != this->writeVersion)
+            {
+                this->retiredNodes.push_back(node);
+                return;
+            }
+        }
+
+        this->destroyNode(node);
+    }
+
+    void reclaimRetiredNodes()
+    {
+        this->readerEpochs.synchronize();
+
+        for (auto node : this->retiredNodes)
+            this->destroyNode(node);
+
+        this->retiredNodes.clear();
+    }
+
+    // Frees or retires every node of a subtree that was unlinked from the tree
+    void releaseSubtree(IntervalTreeNodePtr node)
+    {
+        if (node == nullptr)
+            return;
+
+        this->releaseSubtree(node->left);
+        this->releaseSubtree(node->right);
+        this->releaseNode(node);
+    }
+
+    // Appends the intervals of a subtree in key order
+    static void collectIntervals(IntervalTreeNodePtr node, std::vector<Data> &out)
+    {
+        if (node == nullptr)
+            return;
+
+        collectIntervals(node->left, out);
+
+        for (const auto &payload : node->payloads)
+            out.push_back(Data{node->low, node->high, payload});
+
+        collectIntervals(node->right, out);
+    }
+
+    // Builds a perfectly balanced subtree out of the runs [firstRun, lastRun) of sorted intervals
+    IntervalTreeNodePtr buildBalanced(const std::vector<Data> &sorted, const std::vector<size_t> &runs, size_t firstRun, size_t lastRun)
+    {
+        if (firstRun == lastRun)
+            return nullptr;
+
+        auto midRun = firstRun + (lastRun - firstRun) / 2;
+        const auto &mid = sorted[runs[midRun]];
+
+        auto node = this->createNode(mid.low, mid.high, mid.payload);
+        for (auto i = runs[midRun] + 1; i < runs[midRun + 1]; i++)
+            node->payloads.insert(sorted[i].payload);
+
+        node->left = this->buildBalanced(sorted, runs, firstRun, midRun);
+        node->right = this->buildBalanced(sorted, runs, midRun + 1, lastRun);
+        updateNode(*node);
+
+        return node;
+    }
+
+    // Nodes are ordered by low and then by high so that intervals sharing the same start stay reachable
+    static bool isKeyLess(const IntervalType &lowA, const IntervalType &highA, const IntervalType &lowB, const IntervalType &highB)
+    {
+        return std::tie(lowA, highA) < std::tie(lowB, highB);
+    }
+
+    static int heightOf(const IntervalTreeNodePtr &node)
+    {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    // Recomputes the height and maxHigh of a node from its children
+    static void updateNode(IntervalTreeNode &node)
+    {
+        node.height = 1 + std::max(heightOf(node.left), heightOf(node.right));
+
+        node.maxHigh = node.high;
+        if (node.left != nullptr)
+            node.maxHigh = std::max(node.maxHigh, node.left->maxHigh);
+        if (node.right != nullptr)
+            node.maxHigh = std::max(node.maxHigh, node.right->maxHigh);
+    }
+
+    // Rotations and rebalancing expect root to be writable
+    void rotateLeft(IntervalTreeNodePtr &root)
+    {
+        IntervalTreeNodePtr pivot = this->writable(root->right);
+        root->right = pivot->left;
+        updateNode(*root);
+
+        pivot->left = root;
+        updateNode(*pivot);
+
+        root = pivot;
+    }
+
+    void rotateRight(IntervalTreeNodePtr &root)
+    {
+        IntervalTreeNodePtr pivot = this->writable(root->left);
+        root->left = pivot->right;
+        updateNode(*root);
+
+        pivot->right = root;
+        updateNode(*pivot);
+
+        root = pivot;
+    }
+
+    // Restores the AVL invariant of a node whose subtrees differ in height by at most 2,
+    // keeping maxHigh correct for every node touched by the rotations
+    void rebalance(IntervalTreeNodePtr &root)
+    {
+        updateNode(*root);
+
+        auto balance = heightOf(root->left) - heightOf(root->right);
+
+        if (balance > 1)
+        {
+            if (heightOf(root->left->left) < heightOf(root->left->right))
+            {
+                root->left = this->writable(root->left);
+                this->rotateLeft(root->left);
+            }
+
+            this->rotateRight(root);
+        }
+        else if (balance < -1)
+        {
+            if (heightOf(root->right->right) < heightOf(root->right->left))
+            {
+                root->right = this->writable(root->right);
+                this->rotateRight(root->right);
+            }
+
+            this->rotateLeft(root);
+        }
+    }
+
     void insertInternal(IntervalTreeNodePtr &root, const Data &data)
     {
         auto [low, high, payload] = data;
 
         if (root == nullptr)
         {
-            root = std::make_unique<IntervalTreeNode>(IntervalTreeNode{{payload}, high, low, high, 0, 0});
+            root = this->createNode(low, high, payload);
             return;
         }
 
+        root = this->writable(root);
+
         if (root->low == low && root->high == high)
         {
             root->payloads.insert(payload);
             return;
         }
 
-        // If root's low value is smaller, then new interval goes to left subtree
-        if (low < root->low)
+        if (isKeyLess(low, high, root->low, root->high))
             insertInternal(root->left, data);
         else
             insertInternal(root->right, data);
 
-        // Update the maxHigh value of this ancestor if needed
-        root->maxHigh = std::max(root->maxHigh, high);
+        // Update height and maxHigh of this ancestor and rotate if needed
+        this->rebalance(root);
+    }
+
+    // Unlinks the node with the smallest key of the subtree and returns it, writable
+    IntervalTreeNodePtr detachMin(IntervalTreeNodePtr &root)
+    {
+        root = this->writable(root);
+
+        if (root->left == nullptr)
+        {
+            IntervalTreeNodePtr minNode = root;
+            root = minNode->right;
+
+            return minNode;
+        }
+
+        auto minNode = detachMin(root->left);
+        this->rebalance(root);
+
+        return minNode;
+    }
+
+    // Joins two trees with all keys of left smaller than pivot and all keys of right greater, heights may differ arbitrarily.
+    // The pivot has to be writable.
+    IntervalTreeNodePtr joinWithPivot(IntervalTreeNodePtr left, IntervalTreeNodePtr pivot, IntervalTreeNodePtr right)
+    {
+        if (heightOf(left) > heightOf(right) + 1)
+        {
+            left = this->writable(left);
+            left->right = this->joinWithPivot(left->right, pivot, right);
+            this->rebalance(left);
+
+            return left;
+        }
+
+        if (heightOf(right) > heightOf(left) + 1)
+        {
+            right = this->writable(right);
+            right->left = this->joinWithPivot(left, pivot, right->left);
+            this->rebalance(right);
+
+            return right;
+        }
+
+        pivot->left = left;
+        pivot->right = right;
+        updateNode(*pivot);
+
+        return pivot;
+    }
+
+    IntervalTreeNodePtr join(IntervalTreeNodePtr left, IntervalTreeNodePtr right)
+    {
+        if (right == nullptr)
+            return left;
+
+        auto pivot = this->detachMin(right);
+        return this->joinWithPivot(left, pivot, right);
+    }
+
+    // Post-order removal of matching payloads, the pruned subtrees are joined back into a balanced tree
+    // with maxHigh fixed on the way up. Nodes for which skipRight holds keep their payloads and right subtree.
+    // Subtrees without matches are left untouched.
+    template <typename Predicate, typename SkipRight>
+    size_t pruneInternal(IntervalTreeNodePtr &root, Predicate &predicate, const SkipRight &skipRight)
+    {
+        if (root == nullptr)
+            return 0;
+
+        IntervalTreeNodePtr left = root->left;
+        auto noRemoved = this->pruneInternal(left, predicate, skipRight);
+
+        if (skipRight(root))
+        {
+            if (noRemoved != 0)
+            {
+                root = this->writable(root);
+                root = this->joinWithPivot(left, root, root->right);
+            }
+
+            return noRemoved;
+        }
+
+        IntervalTreeNodePtr right = root->right;
+        noRemoved += this->pruneInternal(right, predicate, skipRight);
+
+        auto isMatching = [&](const PayloadType &payload)
+        { return predicate(root->low, root->high, payload); };
+
+        size_t noMatching = std::count_if(root->payloads.begin(), root->payloads.end(), isMatching);
+
+        if (noMatching == root->payloads.size())
+        {
+            IntervalTreeNodePtr removed = root;
+
+            root = this->join(left, right);
+            this->releaseNode(removed);
+        }
+        else if (noMatching != 0 || noRemoved != 0)
+        {
+            root = this->writable(root);
+            std::erase_if(root->payloads, isMatching);
+
+            root = this->joinWithPivot(left, root, right);
+        }
+
+        return noRemoved + noMatching;
     }
 
     void removeInternal(IntervalTreeNodePtr &root, const IntervalType &low, const IntervalType &high, std::optional<PayloadType> payload)
@@ -115,88 +750,135 @@ protected:
         if (root == nullptr)
             return;
 
-        if (low < root->low)
+        root = this->writable(root);
+
+        if (isKeyLess(low, high, root->low, root->high))
             removeInternal(root->left, low, high, payload);
-        else if (low > root->low)
+        else if (isKeyLess(root->low, root->high, low, high))
             removeInternal(root->right, low, high, payload);
-        else if (root->high == high)
+        else
         {
             if (payload.has_value())
                 root->payloads.erase(payload.value());
             else
                 root->payloads.clear();
 
-            if (root->payloads.size() == 0)
+            // Other payloads still share this interval, the shape of the tree is unchanged
+            if (root->payloads.size() != 0)
+                return;
+
+            IntervalTreeNodePtr removed = root;
+
+            // Node with only one child or no child: the child subtree is unchanged and may be shared with readers,
+            // it takes the node's place as it is
+            if (root->left == nullptr || root->right == nullptr)
             {
-                // Node with only one child or no child
-                if (root->left == nullptr)
-                {
-                    root = std::move(root->right);
-                    return;
-                }
-                else if (root->right == nullptr)
-                {
-                    root = std::move(root->left);
-                    return;
-                }
+                root = root->left == nullptr ? root->right : root->left;
+                this->releaseNode(removed);
 
-                // Node with two children, get the inorder successor
-                IntervalTreeNode *temp = root->right.get();
+                return;
+            }
 
-                while (temp->left != nullptr)
-                    temp = temp->left.get();
+            // Node with two children, the inorder successor, writable, takes its place
+            auto successor = this->detachMin(root->right);
 
-                // Copy the inorder successor's content to this node
-                root->low = temp->low;
-                root->high = temp->high;
-                root->payloads = temp->payloads;
-                root->maxHigh = std::max(root->left->maxHigh, root->right->maxHigh);
+            successor->left = root->left;
+            successor->right = root->right;
+            root = successor;
 
-                // Delete the inorder successor
-                removeInternal(root->right, temp->low, temp->high, std::nullopt);
-            }            
+            this->releaseNode(removed);
         }
+
+        this->rebalance(root);
     }
 
-    void searchOverlappingIntervals(IntervalTreeNodePtr &root, const IntervalType &low, const IntervalType &high, std::list<Data> &overlaps)
+    // Invokes the visitor for every payload of a node, false if the visitor asked to stop
+    template <typename Visitor>
+    static bool visitPayloads(IntervalTreeNodePtr node, Visitor &visitor)
     {
-        if (root == nullptr)
-            return;
-
-        // If given interval overlaps with root
-        if (low < root->high && high > root->low)
+        for (const auto &payload : node->payloads)
         {
-            for (auto payload : root->payloads)
-                overlaps.push_back(Data{root->low, root->high, payload});
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor &, const IntervalType &, const IntervalType &, const PayloadType &>>)
+                visitor(node->low, node->high, payload);
+            else if (!visitor(node->low, node->high, payload))
+                return false;
         }
 
-        // If left child of root is present and maxHigh of left child is
-        // greater than or equal to given interval, then i may
-        // overlap with an interval in left subtree
-        if (root->left != nullptr && root->left->maxHigh >= low)
-            searchOverlappingIntervals(root->left, low, high, overlaps);
+        return true;
+    }
+
+    template <typename Visitor>
+    static bool visitOverlappingIntervals(IntervalTreeNodePtr root, const IntervalType &low, const IntervalType &high, Visitor &visitor)
+    {
+        // No interval in this subtree ends after the given interval starts
+        if (root == nullptr || root->maxHigh <= low)
+            return true;
+
+        if (!visitOverlappingIntervals(root->left, low, high, visitor))
+            return false;
+
+        // If given interval overlaps with root
+        if (low < root->high && high > root->low && !visitPayloads(root, visitor))
+            return false;
+
+        // Intervals in the right subtree start at or after root, so they can only overlap if root starts before high
+        if (root->low < high)
+            return visitOverlappingIntervals(root->right, low, high, visitor);
 
-        // interval can only overlap with right subtree
-        if (root->right != nullptr)
-            searchOverlappingIntervals(root->right, low, high, overlaps);
+        return true;
     }
 
-    void searchIntervalsEndingBefore(IntervalTreeNodePtr &root, const IntervalType &high, std::list<Data> &overlaps)
+    template <typename Visitor>
+    static bool visitIntervalsEndingBefore(IntervalTreeNodePtr root, const IntervalType &high, Visitor &visitor)
     {
         if (root == nullptr)
-            return;
+            return true;
+
+        if (!visitIntervalsEndingBefore(root->left, high, visitor))
+            return false;
 
         // If given interval ends before high
-        if (root->high <= high)
-        {
-            for (auto payload : root->payloads)
-                overlaps.push_back(Data{root->low, root->high, payload});
-        }
+        if (root->high <= high && !visitPayloads(root, visitor))
+            return false;
+
+        // Intervals in the right subtree start at or after root and cannot end before high once root starts after it
+        if (root->low <= high)
+            return visitIntervalsEndingBefore(root->right, high, visitor);
+
+        return true;
+    }
+
+    // Moves from past the intervals holding payload that overlap [from, from + length), returns false once the gap is found
+    template <typename Length>
+    static bool walkGap(IntervalTreeNodePtr root, IntervalType &from, const Length &length, const PayloadType &payload)
+    {
+        if (root == nullptr || root->maxHigh <= from)
+            return true;
+
+        if (!walkGap(root->left, from, length, payload))
+            return false;
+
+        // Root and the right subtree start after the gap
+        if (root->low >= from + length)
+            return false;
+
+        if (root->high > from && root->payloads.contains(payload))
+            from = root->high;
+
+        return walkGap(root->right, from, length, payload);
+    }
+
+    static bool findOverlap(IntervalTreeNodePtr root, const IntervalType &low, const IntervalType &high, const std::optional<PayloadType> &payload)
+    {
+        if (root == nullptr || root->maxHigh <= low)
+            return false;
+
+        if (low < root->high && high > root->low && (!payload.has_value() || root->payloads.contains(payload.value())))
+            return true;
 
-        if (root->left != nullptr && root->left->low <= high)
-            searchIntervalsEndingBefore(root->left, high, overlaps);
+        if (findOverlap(root->left, low, high, payload))
+            return true;
 
-        if (root->right != nullptr)
-            searchIntervalsEndingBefore(root->right, high, overlaps);
+        return root->low < high && findOverlap(root->right, low, high, payload);
     }
-};
\ No newline at end of file
+};
@@ -1,8 +1,17 @@
+#pragma once
+
 #include <string_view>
 #include <optional>
 #include <unordered_map>
+#include <deque>
+#include <map>
+#include <cstdint>
 #include <functional>
-#include <queue>
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
 
 #include <thread>
 #include <atomic>
@@ -14,6 +23,11 @@
 using namespace std::chrono;
 
 #include "interval_tree.hpp"
+#include "flat_interval_index.hpp"
+#include "dynamic_bitset.hpp"
+#include "timing_wheel.hpp"
+#include "scheduler_metrics.hpp"
+#include "scheduler_clock.hpp"
 #include <iostream>
 
 class DateTimeSlot
@@ -30,7 +44,7 @@ public:
     {
     }
 
-    auto getLength() { return this->duration; }
+    auto getLength() const { return this->duration; }
 
     const auto getStartTime() const { return this->timePoint; }
     const auto getEndTime() const { return this->timePoint + this->duration; }
@@ -40,22 +54,56 @@ public:
         return this->timePoint == other.timePoint && this->duration == other.duration;
     }
 
-    std::string toString()
+    // Writes the slot as "YYYY-MM-DD HH:MM - YYYY-MM-DD HH:MM" in UTC without allocating, following std::to_chars:
+    // returns the end of the written characters, or last and std::errc::value_too_large if they do not fit
+    std::to_chars_result toChars(char *first, char *last) const
     {
-        auto start = duration_cast<seconds>(this->getStartTime().time_since_epoch()).count();
-        auto end = duration_cast<seconds>(this->getEndTime().time_since_epoch()).count();
+        auto result = writeTime(first, last, this->getStartTime());
+        if (result.ec != std::errc() || last - result.ptr < 3)
+            return {last, std::errc::value_too_large};
 
-        char startBuf[50] = {0}, endBuf[50] = {0};
+        result.ptr = std::copy_n(" - ", 3, result.ptr);
+        return writeTime(result.ptr, last, this->getEndTime());
+    }
 
-        auto ts_str = std::string(ctime_r(&start, startBuf)) + " " + std::string(ctime_r(&end, endBuf));
-        ts_str.erase(std::remove(ts_str.begin(), ts_str.end(), '\n'), ts_str.cend());
+    std::string toString() const
+    {
+        char buffer[64];
+        auto result = this->toChars(buffer, buffer + sizeof(buffer));
 
-        return ts_str;
+        return std::string(buffer, result.ptr);
     }
 
 protected:
     sys_time<milliseconds> timePoint;
     minutes duration;
+
+    static std::to_chars_result writeTime(char *first, char *last, const sys_time<milliseconds> &time)
+    {
+        auto day = floor<days>(time);
+        year_month_day ymd(day);
+        hh_mm_ss hms(floor<minutes>(time - day));
+
+        auto result = std::to_chars(first, last, static_cast<int>(ymd.year()));
+
+        // "-MM-DD HH:MM" after the year
+        if (result.ec != std::errc() || last - result.ptr < 12)
+            return {last, std::errc::value_too_large};
+
+        auto twoDigits = [&](char separator, unsigned value)
+        {
+            *result.ptr++ = separator;
+            *result.ptr++ = static_cast<char>('0' + value / 10);
+            *result.ptr++ = static_cast<char>('0' + value % 10);
+        };
+
+        twoDigits('-', static_cast<unsigned>(ymd.month()));
+        twoDigits('-', static_cast<unsigned>(ymd.day()));
+        twoDigits(' ', static_cast<unsigned>(hms.hours().count()));
+        twoDigits(':', static_cast<unsigned>(hms.minutes().count()));
+
+        return result;
+    }
 };
 
 class MeetingRoom
@@ -67,60 +115,408 @@ public:
     MeetingRoom &operator=(MeetingRoom &) = default;
     MeetingRoom &operator=(MeetingRoom &&) = default;
 
-    MeetingRoom(const std::string &a_name, size_t a_seats) : name(a_name), sv_name(name), seats(a_seats)
+    MeetingRoom(const std::string &a_name, size_t a_seats) : name(a_name), seats(a_seats)
     {     
     }
 
-    const std::string_view& getName() const { return this->sv_name; }
+    // Views the name owned by this object, copies and moves view their own copy
+    std::string_view getName() const { return this->name; }
+
+    size_t getSeats() const { return this->seats; }
 
 protected:
     std::string name;
-    std::string_view sv_name;
     size_t seats;    
 };
 
+// Compact booking timestamps: minutes since epoch in 32 bits, enough for about 4000 years either side
+using MinuteTime = sys_time<duration<int32_t, std::ratio<60>>>;
+
+// Dense index of a registered meeting room, assigned by MeetingRoomScheduler::registerRoom
+using RoomId = uint32_t;
+
+// Identifies a booking made by the scheduler until it is cancelled or expires. Ids are reused
+// with a new generation so that handles of former bookings are rejected.
+struct BookingHandle
+{
+    uint32_t id = 0;
+    uint32_t generation = 0; // 0 for bookings not made by the scheduler
+
+    bool isValid() const { return this->generation != 0; }
+};
+
+static_assert(std::is_trivially_copyable_v<BookingHandle>);
+
 struct MeetingRoomBooking
 {
-    MeetingRoom meetingRoom;
+    RoomId roomId;
+    DateTimeSlot timeSlot;
+    BookingHandle handle = {};
+};
+
+class BookingJournal;
+
+// Free slot found in a room, not reserved until it is requested
+struct FreeSlot
+{
+    RoomId roomId;
     DateTimeSlot timeSlot;
 };
 
-class MeetingRoomScheduler
+// Slot repeated every period, count times in all. Occurrences may not overlap each other, the period is at least the slot's length.
+struct RecurrenceRule
+{
+    DateTimeSlot firstSlot;
+    minutes period;
+    uint32_t count;
+
+    // Repeats firstSlot every period up to the last occurrence starting at or before lastStart
+    static RecurrenceRule until(const DateTimeSlot &firstSlot, minutes period, const system_clock::time_point &lastStart)
+    {
+        if (lastStart < firstSlot.getStartTime())
+            return RecurrenceRule{firstSlot, period, 0};
+
+        return RecurrenceRule{firstSlot, period, static_cast<uint32_t>((lastStart - firstSlot.getStartTime()) / period + 1)};
+    }
+
+    DateTimeSlot occurrence(uint32_t index) const
+    {
+        return DateTimeSlot(this->firstSlot.getStartTime() + index * this->period, static_cast<unsigned int>(this->firstSlot.getLength().count()));
+    }
+};
+
+// Identifies a recurring booking until it is cancelled or its last occurrence is over, with ids reused as for BookingHandle
+struct SeriesHandle
+{
+    uint32_t id = 0;
+    uint32_t generation = 0;
+
+    bool isValid() const { return this->generation != 0; }
+};
+
+struct RecurringBooking
+{
+    RoomId roomId;
+    RecurrenceRule rule;
+    SeriesHandle handle;
+};
+
+// Books meeting rooms over an interval index type offering the IntervalTree interface, keyed on meeting
+// timestamps with room ids as payloads (IntervalTree or FlatIntervalIndex). Keys are millisecond timestamps or,
+// to halve the key size of the index, MinuteTime with slots rounded down to whole minutes. Bookings expire on
+// the time of ClockType, RealClock or a VirtualClock advanced by advanceClock.
+template <typename IndexType = IntervalTree<sys_time<milliseconds>, RoomId>, typename ClockType = RealClock>
+class BasicMeetingRoomScheduler
 {
 public:
-    MeetingRoomScheduler();
+    explicit BasicMeetingRoomScheduler(ClockType a_clock = ClockType());
+
+    RoomId registerRoom(const MeetingRoom &m);
 
-    void registerRoom(const MeetingRoom &m);
+    // Resolves a room id of a booking, the reference stays valid for the lifetime of the scheduler
+    const MeetingRoom &getRoom(RoomId roomId);
 
     std::optional<MeetingRoomBooking> requestRoom(const DateTimeSlot &ts);
     std::optional<MeetingRoomBooking> requestRoom(const std::string &roomName, const DateTimeSlot &ts);
 
-    void cancelBooking(const MeetingRoomBooking &booking);
+    // Books the smallest free room with at least minSeats seats, the one with the lowest id among equally large rooms
+    std::optional<MeetingRoomBooking> requestRoom(const DateTimeSlot &ts, size_t minSeats);
+
+    // Books any free room for each slot of a burst of requests, results are in the order of the slots.
+    // Slots are swept in start order so that conflicts with stored bookings and within the batch are resolved
+    // in one pass, the accepted bookings are then committed with one writer lock per day shard.
+    std::vector<std::optional<MeetingRoomBooking>> requestRooms(std::span<const DateTimeSlot> slots);
+
+    // Cancels a booking through its handle in O(log n), returns false if it was already cancelled or expired.
+    // Bookings without a handle, e.g. from a journal or trace, are looked up by room and slot.
+    bool cancelBooking(const MeetingRoomBooking &booking);
+    bool cancelBooking(BookingHandle handle);
+
+    // Checks if the room has no booking overlapping the slot
+    bool isRoomAvailable(const std::string &roomName, const DateTimeSlot &ts);
+
+    // Earliest slot of min_duration minutes starting at or after `after` in which the room has no booking, nullopt for unknown rooms.
+    // Found by walking each day's index in start order from `after`, skipping the subtrees that end before the candidate gap.
+    std::optional<DateTimeSlot> findNextFreeSlot(const std::string &roomName, const system_clock::time_point &after, unsigned int min_duration);
+
+    // Earliest such slot over all rooms, in the room with the lowest id on ties, nullopt when no room is registered.
+    // Bookings of all rooms are swept in start order from `after` on until the earliest room's gap is final.
+    std::optional<FreeSlot> findNextFreeSlot(const system_clock::time_point &after, unsigned int min_duration);
+
+    // Books the room for every occurrence of the rule, or for none if any of them conflicts. The series is stored as one rule:
+    // its occurrences are inserted in the index once they come within SeriesHorizon of the clock, requests reaching further
+    // check the rules of the series instead, and conflicts are checked over the whole series in one pass. Returns nullopt for
+    // rules without occurrences or with a period shorter than the slot.
+    std::optional<RecurringBooking> requestRecurringRoom(const std::string &roomName, const RecurrenceRule &rule);
+
+    // Same in the room of lowest id free for the whole series
+    std::optional<RecurringBooking> requestRecurringRoom(const RecurrenceRule &rule);
+
+    // Cancels the occurrences of a series still to come, returns false for stale handles
+    bool cancelSeries(SeriesHandle handle);
+
+    // Cancels one occurrence of a series, returns false for stale handles and for occurrences past the count or already cancelled
+    bool cancelOccurrence(SeriesHandle handle, uint32_t index);
+
+    // How far ahead of the clock occurrences of recurring bookings are kept in the index
+    static constexpr days SeriesHorizon{28};
+
+    // Occupancy of the registered rooms in blocks of step from `from` up to `to`, the last block possibly shorter: bit b of
+    // row r is set when room r has a booking overlapping block b. One row of gridRowWords(from, to, step) words per room is
+    // written to grid. Bookings of the window are visited once per day shard and mark their blocks a word at a time; with
+    // noThreads > 1 the blocks are split in word-aligned ranges swept in parallel.
+    // Returns the number of rows written, 0 when grid is too small for every registered room.
+    size_t availabilityGrid(const system_clock::time_point &from, const system_clock::time_point &to, minutes step, std::span<uint64_t> grid,
+                            unsigned int noThreads = 1);
+
+    // Words of a row of availabilityGrid
+    static size_t gridRowWords(const system_clock::time_point &from, const system_clock::time_point &to, minutes step);
+
+    // Counters and latency percentiles of the operations so far, summed up over the threads that ran them
+    SchedulerStats stats() const;
+
+    // Restores bookings, e.g. after a restart, without checking them for conflicts. Every day shard is bulk loaded once
+    // and the expiry of all bookings is scheduled under a single lock. Bookings of unregistered rooms are skipped,
+    // returns the number of imported bookings. Their handles are looked up with findBooking.
+    size_t importBookings(std::span<const MeetingRoomBooking> bookings, bool sortInParallel = false);
 
-    virtual ~MeetingRoomScheduler();
+    // Stored booking of the room for exactly that slot with its handle, e.g. one that was imported or recovered
+    std::optional<MeetingRoomBooking> findBooking(RoomId roomId, const DateTimeSlot &ts);
+
+    // Makes bookings durable: book and cancel records are committed to the journal before the operations return,
+    // with the syncs of concurrent operations batched by the journal. Attached before serving requests, nullptr detaches it.
+    // Operations throw std::system_error when the journal cannot be written.
+    void attachJournal(BookingJournal *a_journal);
+
+    // Stored bookings, once each, without handles
+    std::vector<MeetingRoomBooking> exportBookings();
+
+    // Writes a snapshot of the stored bookings and retires the journal records it covers. Throws std::system_error on I/O errors.
+    void writeSnapshot(const std::string &snapshotPath);
+
+    // Bulk loads the bookings of a snapshot and replays the retired and current journal over them by room id, skipping
+    // bookings that are already stored. Nothing is journaled again, the rooms have to be registered again in the same order.
+    // Returns the number of bookings loaded from the snapshot and booked again from the journals, found with findBooking.
+    size_t recover(const std::string &snapshotPath, const std::string &journalPath);
+
+    // Current time of the scheduler's clock
+    typename ClockType::time_point now() const { return this->clock.now(); }
+
+    // Moves virtual time forward and expires the bookings ended by then on the calling thread,
+    // returns the number of expired bookings
+    size_t advanceClock(typename ClockType::time_point time)
+        requires ClockType::IsVirtual;
+
+    virtual ~BasicMeetingRoomScheduler();
 
 protected:
-    using IntervalType = sys_time<milliseconds>; // meeting timestamp
-    using IntervalPayload = std::string_view;    // meeting room name
+    using IntervalType = typename IndexType::Interval; // meeting timestamp
+    using IntervalPayload = typename IndexType::Payload; // meeting room id
+
+    static_assert(std::is_same_v<typename IntervalType::clock, system_clock> && std::is_integral_v<typename IntervalType::rep>, "Meetings are indexed by system_clock timestamps");
+    static_assert(std::is_same_v<IntervalPayload, RoomId>, "Meetings are indexed by room id");
+
+    // Booked intervals of one day, a booking is stored in the shard of every day it spans.
+    // Bookings within a single day rely on the atomic tree operations under a shared shard lock,
+    // bookings spanning several days lock all their shards exclusively, in day order.
+    struct BookingShard
+    {
+        std::shared_mutex lck_shard;
+        IndexType index;
+    };
+
+    ClockType clock;
+
+    // Storage for booked intervals, shards are keyed by days since epoch and created on demand.
+    // Operations hold lck_shards shared while using shards, expiry drops past days under the unique lock.
+    std::shared_mutex lck_shards;
+    std::map<int64_t, std::unique_ptr<BookingShard>> shards;
+
+    // Expiry of past meetings by booking id, in milliseconds ticks of their end time
+    TimingWheel<uint32_t> expiryWheel{this->clock.now().time_since_epoch().count()};
+
+    // Bookings made by the scheduler indexed by handle id, guarded by lck_cleanup
+    struct BookingEntry
+    {
+        typename IndexType::Data interval;
+        TimingWheel<uint32_t>::EntryId expiry = 0;
+        uint32_t generation = 1;
+        bool booked = false;
+    };
+
+    std::vector<BookingEntry> bookingEntries;
+    std::vector<uint32_t> freeBookingEntries;
+
+    // Ids of the booked entries by interval, for bookings cancelled without a handle, guarded by lck_cleanup
+    struct IntervalHash
+    {
+        size_t operator()(const typename IndexType::Data &interval) const
+        {
+            auto hash = static_cast<uint64_t>(interval.low.time_since_epoch().count());
+            hash = hash * 0x9E3779B97F4A7C15 ^ static_cast<uint64_t>(interval.high.time_since_epoch().count());
+            hash = hash * 0x9E3779B97F4A7C15 ^ interval.payload;
+
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+
+    struct IntervalEqual
+    {
+        bool operator()(const typename IndexType::Data &a, const typename IndexType::Data &b) const
+        {
+            return a.low == b.low && a.high == b.high && a.payload == b.payload;
+        }
+    };
 
-    // Storage for booked intervals
-    IntervalTree<IntervalType, IntervalPayload> iTree;
+    std::unordered_multimap<typename IndexType::Data, uint32_t, IntervalHash, IntervalEqual> bookingIds;
 
-    // Heap for cleaning up past meetings
-    std::priority_queue<IntervalType, std::vector<IntervalType>, std::greater<IntervalType>> endTimes;
+    // Time the cleanup thread sleeps until, bookings ending earlier wake it up
+    sys_time<milliseconds> cleanupWakeupTime = sys_time<milliseconds>::max();
 
-    // Storage of registered meeting rooms
+    // Storage of registered meeting rooms indexed by RoomId, names are only used to look up ids
     std::shared_mutex lck_meetingRooms;
-    std::unordered_map<std::string, MeetingRoom> meetingRooms;
+    std::deque<MeetingRoom> meetingRooms;
+    std::unordered_map<std::string, RoomId> roomIds;
+
+    // Room ids by ascending seats then id, and the rank of every room in that order. Free rooms of a slot are
+    // tracked in rank order, so the best fit is the first free rank from the first room large enough.
+    std::vector<RoomId> roomsBySeats;
+    std::vector<uint32_t> seatRanks;
 
     mutable std::recursive_mutex lck_cleanup;
     mutable std::condition_variable_any cv_wakeCleanupThread;
     std::atomic_bool stop = false;
     std::atomic_bool restart = false;
 
+    // Only started on real time
     std::thread cleanupThread;
     void run_cleanup();
 
-    std::set<IntervalPayload> findConflictingRooms(const DateTimeSlot &ts);
-    MeetingRoomBooking bookRoom(const MeetingRoom &room, const DateTimeSlot &ts);
-};
\ No newline at end of file
+    // Expires the bookings ended by the clock's time and arms the next wakeup, the caller holds lck_cleanup through lock.
+    // Returns the number of expired bookings.
+    size_t expireBookings(std::unique_lock<std::recursive_mutex> &lock);
+
+    // Recurring bookings indexed by handle id, guarded by lck_series. Occurrences starting before seriesMaterializedUntil
+    // (milliseconds since epoch) are in the index, later ones only in their rule: bookings and queries reaching past it hold
+    // lck_series shared while they check the rules. lck_series is taken after lck_meetingRooms and before lck_shards.
+    struct Series
+    {
+        RecurrenceRule rule;
+        RoomId roomId = 0;
+        uint32_t noMaterialized = 0; // leading occurrences inserted in the index
+        std::vector<bool> cancelled;
+        uint32_t generation = 1;
+        bool active = false;
+    };
+
+    std::shared_mutex lck_series;
+    std::vector<Series> series;
+    std::vector<uint32_t> freeSeries;
+    std::atomic<int64_t> seriesMaterializedUntil = 0;
+
+    // Inserts the occurrences starting within SeriesHorizon from now, rounded up to whole days. Returns false if they already were.
+    bool materializeSeries();
+
+    std::optional<RecurringBooking> bookSeries(const RecurrenceRule &rule, std::optional<RoomId> roomId);
+
+    // Locks lck_series shared if [.., end) reaches past the materialized occurrences, otherwise returns an empty lock
+    std::shared_lock<std::shared_mutex> lockPendingSeries(const sys_time<milliseconds> &end);
+
+    // Calls fn(roomId, occurrence) for the occurrences not yet in the index overlapping [low, high), the caller holds lck_series
+    template <typename Fn>
+    void forEachPendingOccurrence(const sys_time<milliseconds> &low, const sys_time<milliseconds> &high, Fn &&fn);
+
+    // Recorded without locks by the threads running the operations
+    SchedulerMetrics metrics;
+
+    // Records are appended under lck_cleanup while the operation is applied, so that the journal keeps the order in which
+    // bookings and cancellations of a slot took effect, and waited for once the lock is released
+    BookingJournal *journal = nullptr;
+
+    // Held shared by cancellations from their journal record until their booking is out of the index, exclusively by
+    // writeSnapshot around the rotation, so that a snapshot holds no booking whose cancel record was retired
+    std::shared_mutex lck_rotate;
+
+    // Books the free room of lowest id, or with minSeats the best fit
+    std::optional<MeetingRoomBooking> bookAnyRoom(const DateTimeSlot &ts, std::optional<size_t> minSeats = std::nullopt);
+    std::optional<MeetingRoomBooking> bookNamedRoom(const std::string &roomName, const DateTimeSlot &ts);
+
+    // Calls fn(low, high, roomId) once for every stored booking, from the first of its days still stored
+    template <typename Fn>
+    void forEachStoredBooking(Fn &&fn);
+
+    // importBookings, journaling the bookings only if journaled
+    size_t loadBookings(std::span<const MeetingRoomBooking> bookings, bool sortInParallel, bool journaled);
+
+    // Inserts the interval unless its room has an overlapping booking
+    bool tryInsertBooking(const typename IndexType::Data &booking);
+
+    // Removes the interval from the shards of its days, without looking up its expiry
+    void removeBooking(const typename IndexType::Data &booking);
+
+    // Schedules the cleanup of a booking whose interval was already inserted in the shards
+    MeetingRoomBooking bookRoom(RoomId roomId, const DateTimeSlot &ts);
+
+    // Assigns a handle to a booking and schedules its expiry, the caller holds lck_cleanup.
+    // Sets restart_cleanup when the cleanup thread has to be restarted to wake up earlier.
+    BookingHandle scheduleExpiry(RoomId roomId, const DateTimeSlot &ts, bool &restart_cleanup);
+
+    // Frees the id of a cancelled or expired booking for reuse under the next generation, the caller holds lck_cleanup
+    void releaseBooking(uint32_t id);
+
+    // Cancels the expiry of a booked entry and frees its id, returns its interval for removal from the index.
+    // The caller holds lck_cleanup.
+    typename IndexType::Data unbook(uint32_t id);
+
+    // Same for the entry booked on the interval, nullopt if there is none
+    std::optional<typename IndexType::Data> unbook(const typename IndexType::Data &interval);
+
+    // Appends the cancel record of an unbooked interval, the caller holds lck_cleanup. Returns the sequence number to wait for,
+    // 0 when nothing was appended.
+    uint64_t appendCancelRecord(const std::optional<typename IndexType::Data> &interval);
+
+    // Removes a cancelled booking from the index and waits for its cancel record, records the outcome of the cancellation
+    bool removeCancelledBooking(const std::optional<typename IndexType::Data> &interval, uint64_t seq, SchedulerMetrics::Timer &timer);
+    void restartCleanup();
+
+    static int64_t dayOf(const IntervalType &time);
+
+    // Index keys of a slot, rounded down to the precision of IntervalType
+    static IntervalType lowOf(const DateTimeSlot &ts) { return floor<typename IntervalType::duration>(ts.getStartTime()); }
+    static IntervalType highOf(const DateTimeSlot &ts) { return floor<typename IntervalType::duration>(ts.getEndTime()); }
+
+    static sys_time<milliseconds> timeOf(const IntervalType &key) { return time_point_cast<milliseconds>(key); }
+
+    // Collects the shards of the days spanned by [from, to) in day order, creating missing ones,
+    // and returns the shared lock on the shard map that keeps them alive
+    std::shared_lock<std::shared_mutex> lockShardsOf(const IntervalType &from, const IntervalType &to, std::vector<BookingShard *> &slotShards);
+
+    // Calls fn(shard) for the existing shards of the days spanned by [from, to), the caller holds lck_shards
+    template <typename Fn>
+    void forEachShardOf(const IntervalType &from, const IntervalType &to, Fn &&fn);
+
+    // Calls sweep(low, high, roomId) for the bookings ending after `after` in start order until it returns false, the caller holds lck_shards.
+    // Bookings spanning several days are visited again, out of order, in the shards of their later days.
+    // `after` is copied, sweep may move on the candidate it was taken from.
+    template <typename Fn>
+    void sweepBookingsFrom(IntervalType after, Fn &&sweep);
+
+    // Drops the shards of past days and prunes the bookings of today ending before now
+    void removeExpiredBookings(const sys_time<milliseconds> &now);
+};
+
+// Instantiated in meeting_rooms.cpp
+extern template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId>>;
+extern template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId, PooledNodes, SnapshotReads>>;
+extern template class BasicMeetingRoomScheduler<FlatIntervalIndex<sys_time<milliseconds>, RoomId>>;
+extern template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId>, VirtualClock>;
+extern template class BasicMeetingRoomScheduler<IntervalTree<MinuteTime, RoomId>>;
+extern template class BasicMeetingRoomScheduler<FlatIntervalIndex<MinuteTime, RoomId>>;
+
+using MeetingRoomScheduler = BasicMeetingRoomScheduler<>;
+
+// Indexes bookings on 32-bit minute keys
+using CompactMeetingRoomScheduler = BasicMeetingRoomScheduler<IntervalTree<MinuteTime, RoomId>>;
+
+// Runs on simulated time, for tests and benchmarks of expiry
+using SimulatedMeetingRoomScheduler = BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId>, VirtualClock>;
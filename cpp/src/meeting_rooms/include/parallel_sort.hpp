@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+// Sorts [first, last) by splitting it in chunks sorted on their own threads and merged pairwise, also on threads.
+// Small ranges or a single hardware thread fall back to std::sort.
+template <typename RandomIt, typename Compare>
+void parallelSort(RandomIt first, RandomIt last, Compare compare)
+{
+    constexpr size_t MinChunkSize = 1 << 14;
+
+    auto size = static_cast<size_t>(std::distance(first, last));
+    size_t noChunks = std::max(1u, std::thread::hardware_concurrency());
+
+    while (noChunks > 1 && size / noChunks < MinChunkSize)
+        noChunks /= 2;
+
+    if (noChunks <= 1)
+    {
+        std::sort(first, last, compare);
+        return;
+    }
+
+    auto chunkStart = [&](size_t chunk)
+    { return first + static_cast<std::ptrdiff_t>(size * chunk / noChunks); };
+
+    {
+        std::vector<std::jthread> sorters;
+        for (size_t chunk = 0; chunk < noChunks; chunk++)
+            sorters.emplace_back([&, chunk]
+                                 { std::sort(chunkStart(chunk), chunkStart(chunk + 1), compare); });
+    }
+
+    // Each round merges neighbouring runs of the previous one
+    for (size_t width = 1; width < noChunks; width *= 2)
+    {
+        std::vector<std::jthread> mergers;
+
+        for (size_t chunk = 0; chunk + width < noChunks; chunk += 2 * width)
+            mergers.emplace_back([&, chunk]
+                                 { std::inplace_merge(chunkStart(chunk), chunkStart(chunk + width), chunkStart(std::min(chunk + 2 * width, noChunks)), compare); });
+    }
+}
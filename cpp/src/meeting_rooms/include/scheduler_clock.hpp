@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Clock policies of the scheduler, telling the time bookings expire at
+
+// Wall clock time, bookings are expired by the cleanup thread as their end time passes
+struct RealClock
+{
+    using time_point = std::chrono::sys_time<std::chrono::milliseconds>;
+
+    static constexpr bool IsVirtual = false;
+
+    time_point now() const { return std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now()); }
+};
+
+// Manually advanced time, bookings are expired synchronously by the thread advancing it and no cleanup thread is started
+class VirtualClock
+{
+public:
+    using time_point = std::chrono::sys_time<std::chrono::milliseconds>;
+
+    static constexpr bool IsVirtual = true;
+
+    VirtualClock() : VirtualClock(RealClock().now())
+    {
+    }
+
+    explicit VirtualClock(time_point start) : ticks(start.time_since_epoch().count())
+    {
+    }
+
+    VirtualClock(const VirtualClock &other) : ticks(other.ticks.load())
+    {
+    }
+
+    time_point now() const { return time_point(std::chrono::milliseconds(this->ticks.load(std::memory_order_acquire))); }
+
+    // Time never goes back, earlier times are ignored
+    void advanceTo(time_point time)
+    {
+        auto current = this->ticks.load(std::memory_order_relaxed);
+        auto target = time.time_since_epoch().count();
+
+        while (current < target && !this->ticks.compare_exchange_weak(current, target, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+protected:
+    std::atomic<int64_t> ticks;
+};
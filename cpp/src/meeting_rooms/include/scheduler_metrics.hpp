@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// Operations of the scheduler that are counted and timed
+enum class SchedulerOp : uint32_t
+{
+    Book,
+    Query,
+    Cancel,
+    Expiry,
+    BookBatch
+};
+
+constexpr size_t NoSchedulerOps = 5;
+
+// Latency histogram in nanoseconds with 8 linear buckets per power of two, so that percentiles are
+// reported with at most 12.5% error from nanoseconds up to a few minutes
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 3;
+    static constexpr int NoPowersOfTwo = 37;
+    static constexpr size_t NoBuckets = NoPowersOfTwo << SubBucketBits;
+
+    static size_t bucketOf(uint64_t nanoseconds)
+    {
+        constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+
+        // Values below SubBuckets get a bucket each, larger ones a bucket per 1/SubBuckets of their power of two
+        if (nanoseconds < SubBuckets)
+            return static_cast<size_t>(nanoseconds);
+
+        auto power = std::bit_width(nanoseconds) - 1;
+        auto subBucket = (nanoseconds >> (power - SubBucketBits)) & (SubBuckets - 1);
+
+        return std::min(NoBuckets - 1, static_cast<size_t>(((power - SubBucketBits + 1) << SubBucketBits) + subBucket));
+    }
+
+    // Largest value that falls in a bucket
+    static uint64_t bucketUpperBound(size_t bucket)
+    {
+        constexpr uint64_t SubBuckets = uint64_t(1) << SubBucketBits;
+
+        if (bucket < SubBuckets)
+            return bucket;
+
+        auto power = (bucket >> SubBucketBits) + SubBucketBits - 1;
+        auto subBucket = bucket & (SubBuckets - 1);
+
+        return ((SubBuckets + subBucket + 1) << (power - SubBucketBits)) - 1;
+    }
+
+    void add(std::chrono::nanoseconds latency, uint64_t noSamples = 1)
+    {
+        this->buckets[bucketOf(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)))] += noSamples;
+        this->noSamples += noSamples;
+    }
+
+    void addToBucket(size_t bucket, uint64_t noSamples)
+    {
+        this->buckets[bucket] += noSamples;
+        this->noSamples += noSamples;
+    }
+
+    void merge(const LatencyHistogram &other)
+    {
+        for (size_t bucket = 0; bucket < NoBuckets; bucket++)
+            this->buckets[bucket] += other.buckets[bucket];
+
+        this->noSamples += other.noSamples;
+    }
+
+    uint64_t getCount() const { return this->noSamples; }
+
+    // Latency below which the given fraction of the samples falls, e.g. 0.99 for p99
+    std::chrono::nanoseconds percentile(double fraction) const
+    {
+        if (this->noSamples == 0)
+            return std::chrono::nanoseconds(0);
+
+        auto rank = static_cast<uint64_t>(fraction * static_cast<double>(this->noSamples - 1)) + 1;
+        uint64_t seen = 0;
+
+        for (size_t bucket = 0; bucket < NoBuckets; bucket++)
+        {
+            seen += this->buckets[bucket];
+            if (seen >= rank)
+                return std::chrono::nanoseconds(bucketUpperBound(bucket));
+        }
+
+        return std::chrono::nanoseconds(bucketUpperBound(NoBuckets - 1));
+    }
+
+protected:
+    std::array<uint64_t, NoBuckets> buckets = {};
+    uint64_t noSamples = 0;
+};
+
+// Aggregated counters of one operation: calls, calls that succeeded (bookings made, free rooms found by
+// queries, bookings expired; not tracked for cancellations) and the latency of each API call. Batches of
+// bookings count their slots as calls and take one latency sample per batch.
+struct OpStats
+{
+    uint64_t calls = 0;
+    uint64_t succeeded = 0;
+
+    LatencyHistogram latency;
+};
+
+struct SchedulerStats
+{
+    std::array<OpStats, NoSchedulerOps> ops;
+
+    const OpStats &operator[](SchedulerOp op) const { return this->ops[static_cast<size_t>(op)]; }
+};
+
+// Counters and latency histograms sharded per thread: each thread records in its own cache line aligned shard,
+// allocated on its first record, without locks. stats() sums the shards up on demand.
+class SchedulerMetrics
+{
+public:
+    SchedulerMetrics() = default;
+    SchedulerMetrics(const SchedulerMetrics &) = delete;
+    SchedulerMetrics &operator=(const SchedulerMetrics &) = delete;
+
+    ~SchedulerMetrics()
+    {
+        for (auto &shard : this->shards)
+            delete shard.load();
+    }
+
+    void record(SchedulerOp op, std::chrono::nanoseconds latency, uint64_t calls = 1, uint64_t succeeded = 0)
+    {
+        auto &counters = this->localShard().ops[static_cast<size_t>(op)];
+
+        counters.calls.fetch_add(calls, std::memory_order_relaxed);
+        counters.succeeded.fetch_add(succeeded, std::memory_order_relaxed);
+        counters.buckets[LatencyHistogram::bucketOf(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)))].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SchedulerStats stats() const
+    {
+        SchedulerStats stats;
+
+        for (const auto &slot : this->shards)
+        {
+            auto shard = slot.load(std::memory_order_acquire);
+            if (shard == nullptr)
+                continue;
+
+            for (size_t op = 0; op < NoSchedulerOps; op++)
+            {
+                const auto &counters = shard->ops[op];
+
+                stats.ops[op].calls += counters.calls.load(std::memory_order_relaxed);
+                stats.ops[op].succeeded += counters.succeeded.load(std::memory_order_relaxed);
+
+                for (size_t bucket = 0; bucket < LatencyHistogram::NoBuckets; bucket++)
+                {
+                    if (auto noSamples = counters.buckets[bucket].load(std::memory_order_relaxed); noSamples != 0)
+                        stats.ops[op].latency.addToBucket(bucket, noSamples);
+                }
+            }
+        }
+
+        return stats;
+    }
+
+    // Times an operation from construction to stop()
+    class Timer
+    {
+    public:
+        Timer(SchedulerMetrics &a_metrics, SchedulerOp a_op) : metrics(a_metrics), op(a_op), start(std::chrono::steady_clock::now())
+        {
+        }
+
+        void stop(uint64_t calls, uint64_t succeeded)
+        {
+            this->metrics.record(this->op, std::chrono::steady_clock::now() - this->start, calls, succeeded);
+        }
+
+    protected:
+        SchedulerMetrics &metrics;
+        SchedulerOp op;
+        std::chrono::steady_clock::time_point start;
+    };
+
+protected:
+    static constexpr size_t NoShards = 64;
+
+    struct alignas(64) OpCounters
+    {
+        std::atomic<uint64_t> calls = 0;
+        std::atomic<uint64_t> succeeded = 0;
+
+        std::array<std::atomic<uint64_t>, LatencyHistogram::NoBuckets> buckets = {};
+    };
+
+    struct ThreadShard
+    {
+        std::array<OpCounters, NoSchedulerOps> ops;
+    };
+
+    // Threads beyond NoShards share shards, which stays correct since the counters are atomic
+    std::array<std::atomic<ThreadShard *>, NoShards> shards = {};
+
+    ThreadShard &localShard()
+    {
+        static std::atomic<uint32_t> nextShard = 0;
+        thread_local uint32_t shardIndex = nextShard.fetch_add(1, std::memory_order_relaxed) % NoShards;
+
+        auto &slot = this->shards[shardIndex];
+
+        auto shard = slot.load(std::memory_order_acquire);
+        if (shard != nullptr)
+            return *shard;
+
+        // First record of this thread: publish a new shard, or use the one another thread sharing the slot published
+        auto newShard = new ThreadShard();
+        if (slot.compare_exchange_strong(shard, newShard, std::memory_order_acq_rel))
+            return *newShard;
+
+        delete newShard;
+        return *shard;
+    }
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <optional>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+// Hierarchical timing wheel: O(1) schedule and cancel, expiry cost proportional to the expired entries.
+// Deadlines are integer ticks; level L has 64 slots of 64^L ticks each, later deadlines go to an overflow list
+// and are cascaded to lower levels as the wheel time reaches their slot.
+template <typename PayloadType>
+class TimingWheel
+{
+public:
+    using EntryId = uint32_t;
+
+    explicit TimingWheel(int64_t startTick = 0) : now(startTick)
+    {
+        this->heads.fill(NoEntry);
+    }
+
+    // Schedules payload to expire once the wheel advances to deadline, past deadlines expire on the next advance
+    EntryId schedule(int64_t deadline, PayloadType payload)
+    {
+        EntryId id;
+
+        if (this->freeEntries.empty())
+        {
+            id = static_cast<EntryId>(this->entries.size());
+            this->entries.push_back(Entry{deadline, std::move(payload), NoEntry, NoEntry, 0});
+        }
+        else
+        {
+            id = this->freeEntries.back();
+            this->freeEntries.pop_back();
+            this->entries[id] = Entry{deadline, std::move(payload), NoEntry, NoEntry, 0};
+        }
+
+        this->place(id);
+        this->noEntries++;
+
+        return id;
+    }
+
+    // Removes a scheduled entry that has not expired yet
+    void cancel(EntryId id)
+    {
+        this->unlink(id);
+        this->release(id);
+    }
+
+    // Moves the wheel time forward to tick, calling expired(payload) for every entry with deadline <= tick.
+    // Returns the number of expired entries.
+    template <typename Callback>
+    size_t advance(int64_t tick, Callback &&expired)
+    {
+        size_t noExpired = 0;
+
+        while (true)
+        {
+            noExpired += this->expireBucket(static_cast<size_t>(this->now & SlotMask), expired);
+
+            if (this->now >= tick)
+                break;
+
+            this->moveTo(std::min(tick, this->nextEventTick()));
+        }
+
+        return noExpired;
+    }
+
+    // Earliest tick at which advance may expire or cascade entries, none when the wheel is empty
+    std::optional<int64_t> nextExpiry() const
+    {
+        if (this->noEntries == 0)
+            return std::nullopt;
+
+        if (this->heads[this->now & SlotMask] != NoEntry)
+            return this->now;
+
+        return this->nextEventTick();
+    }
+
+    int64_t getTime() const { return this->now; }
+    size_t size() const { return this->noEntries; }
+
+protected:
+    static constexpr EntryId NoEntry = static_cast<EntryId>(-1);
+
+    static constexpr int SlotBits = 6;
+    static constexpr int64_t SlotMask = (1 << SlotBits) - 1;
+    static constexpr int Levels = 6;
+
+    static constexpr size_t SlotsPerLevel = 1 << SlotBits;
+    static constexpr size_t OverflowBucket = Levels * SlotsPerLevel;
+
+    struct Entry
+    {
+        int64_t deadline;
+        PayloadType payload;
+
+        EntryId prev;
+        EntryId next;
+
+        // level * SlotsPerLevel + slot, or OverflowBucket
+        uint32_t bucket;
+    };
+
+    int64_t now;
+    size_t noEntries = 0;
+
+    std::vector<Entry> entries;
+    std::vector<EntryId> freeEntries;
+
+    // List heads of every slot of every level plus the overflow list
+    std::array<EntryId, OverflowBucket + 1> heads;
+
+    // Bit s of level L is set when slot s of that level holds entries
+    std::array<uint64_t, Levels> occupied = {};
+
+    void place(EntryId id)
+    {
+        auto deadline = std::max(this->entries[id].deadline, this->now);
+        auto differingBits = static_cast<uint64_t>(deadline ^ this->now);
+
+        // The level is given by the most significant slot group in which deadline and now differ
+        auto level = differingBits == 0 ? 0 : (std::bit_width(differingBits) - 1) / SlotBits;
+
+        if (level >= Levels)
+            this->link(id, OverflowBucket);
+        else
+            this->link(id, level * SlotsPerLevel + ((deadline >> (level * SlotBits)) & SlotMask));
+    }
+
+    void link(EntryId id, size_t bucket)
+    {
+        auto &entry = this->entries[id];
+
+        entry.bucket = static_cast<uint32_t>(bucket);
+        entry.prev = NoEntry;
+        entry.next = this->heads[bucket];
+
+        if (entry.next != NoEntry)
+            this->entries[entry.next].prev = id;
+
+        this->heads[bucket] = id;
+
+        if (bucket != OverflowBucket)
+            this->occupied[bucket / SlotsPerLevel] |= uint64_t(1) << (bucket % SlotsPerLevel);
+    }
+
+    void unlink(EntryId id)
+    {
+        auto &entry = this->entries[id];
+
+        if (entry.prev != NoEntry)
+            this->entries[entry.prev].next = entry.next;
+        else
+            this->heads[entry.bucket] = entry.next;
+
+        if (entry.next != NoEntry)
+            this->entries[entry.next].prev = entry.prev;
+
+        if (entry.bucket != OverflowBucket && this->heads[entry.bucket] == NoEntry)
+            this->occupied[entry.bucket / SlotsPerLevel] &= ~(uint64_t(1) << (entry.bucket % SlotsPerLevel));
+    }
+
+    void release(EntryId id)
+    {
+        this->freeEntries.push_back(id);
+        this->noEntries--;
+    }
+
+    // Detaches the whole list of a bucket
+    EntryId takeBucket(size_t bucket)
+    {
+        auto head = this->heads[bucket];
+
+        this->heads[bucket] = NoEntry;
+        if (bucket != OverflowBucket)
+            this->occupied[bucket / SlotsPerLevel] &= ~(uint64_t(1) << (bucket % SlotsPerLevel));
+
+        return head;
+    }
+
+    template <typename Callback>
+    size_t expireBucket(size_t bucket, Callback &expired)
+    {
+        size_t noExpired = 0;
+
+        for (auto id = this->takeBucket(bucket); id != NoEntry; noExpired++)
+        {
+            auto next = this->entries[id].next;
+
+            expired(this->entries[id].payload);
+            this->release(id);
+
+            id = next;
+        }
+
+        return noExpired;
+    }
+
+    // Re-places the entries of a bucket relative to the current wheel time
+    void cascade(size_t bucket)
+    {
+        for (auto id = this->takeBucket(bucket); id != NoEntry;)
+        {
+            auto next = this->entries[id].next;
+            this->place(id);
+
+            id = next;
+        }
+    }
+
+    // First tick after now at which a slot of some level starts holding entries
+    int64_t nextEventTick() const
+    {
+        for (int level = 0; level < Levels; level++)
+        {
+            auto shift = level * SlotBits;
+            auto currentSlot = (this->now >> shift) & SlotMask;
+
+            // Slots after the current one in this level's rotation
+            auto laterSlots = currentSlot == SlotMask ? 0 : this->occupied[level] & (~uint64_t(0) << (currentSlot + 1));
+
+            if (laterSlots != 0)
+            {
+                auto rotationStart = (this->now >> (shift + SlotBits)) << (shift + SlotBits);
+                return rotationStart | (static_cast<int64_t>(std::countr_zero(laterSlots)) << shift);
+            }
+        }
+
+        // Only overflow entries are left, the next stop is the end of the top level rotation
+        if (this->heads[OverflowBucket] != NoEntry)
+            return ((this->now >> (Levels * SlotBits)) + 1) << (Levels * SlotBits);
+
+        return std::numeric_limits<int64_t>::max();
+    }
+
+    void moveTo(int64_t tick)
+    {
+        auto previous = this->now;
+        this->now = tick;
+
+        if ((previous >> (Levels * SlotBits)) != (tick >> (Levels * SlotBits)))
+            this->cascade(OverflowBucket);
+
+        // Entries of slots the wheel just entered move down, top levels first so they can cascade further
+        for (int level = Levels - 1; level > 0; level--)
+            this->cascade(level * SlotsPerLevel + ((tick >> (level * SlotBits)) & SlotMask));
+    }
+};
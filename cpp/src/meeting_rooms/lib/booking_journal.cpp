@@ -0,0 +1,267 @@
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/booking_journal.h"
+
+// Writes the whole buffer, retrying short writes, returns 0 or the errno of the failure
+static int writeAll(int fd, const void *data, size_t size)
+{
+    auto bytes = static_cast<const char *>(data);
+
+    while (size > 0)
+    {
+        auto written = ::write(fd, bytes, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return errno;
+        }
+
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return 0;
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+            return;
+
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+
+    if (info.st_size > 0)
+    {
+        this->mapping_size = static_cast<size_t>(info.st_size);
+        this->mapping = ::mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    ::close(fd);
+
+    if (this->mapping == MAP_FAILED)
+    {
+        this->mapping = nullptr;
+        throw std::runtime_error("cannot map " + path);
+    }
+
+    // Recovery reads the file once, front to back
+    if (this->mapping != nullptr)
+        ::madvise(this->mapping, this->mapping_size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->mapping != nullptr)
+        ::munmap(this->mapping, this->mapping_size);
+}
+
+BookingJournal::BookingJournal(const std::string &a_path) : path(a_path)
+{
+    this->fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (this->fd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open journal " + this->path);
+
+    this->flusher = std::thread([this]
+                                { this->run_flusher(); });
+}
+
+BookingJournal::~BookingJournal()
+{
+    {
+        std::lock_guard lock(this->lck_pending);
+        this->stop = true;
+    }
+
+    this->cv_flush.notify_one();
+    this->flusher.join();
+
+    ::close(this->fd);
+}
+
+uint64_t BookingJournal::append(const JournalRecord &record)
+{
+    uint64_t seq;
+    {
+        std::lock_guard lock(this->lck_pending);
+
+        this->pending.push_back(record);
+        seq = ++this->appendedSeq;
+    }
+
+    this->cv_flush.notify_one();
+    return seq;
+}
+
+void BookingJournal::waitDurable(uint64_t seq)
+{
+    std::unique_lock lock(this->lck_pending);
+
+    this->cv_durable.wait(lock, [&]
+                          { return this->durableSeq >= seq || this->writeError != 0; });
+
+    if (this->durableSeq < seq)
+        throw std::system_error(this->writeError, std::generic_category(), "cannot write journal " + this->path);
+}
+
+void BookingJournal::rotate()
+{
+    std::lock_guard guard_file(this->lck_file);
+
+    // Records still pending were appended before the rotation and go to the new journal, replaying them over the snapshot is harmless
+    auto retiredPath = retiredPathOf(this->path);
+
+    // A journal retired for a snapshot that did not complete is still needed, the current records are added to it
+    if (::access(retiredPath.c_str(), F_OK) == 0)
+    {
+        this->appendTo(retiredPath);
+        return;
+    }
+
+    if (::rename(this->path.c_str(), retiredPath.c_str()) != 0)
+        throw std::system_error(errno, std::generic_category(), "cannot retire journal " + this->path);
+
+    auto newFd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_TRUNC, 0644);
+    if (newFd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open journal " + this->path);
+
+    ::close(this->fd);
+    this->fd = newFd;
+}
+
+void BookingJournal::appendTo(const std::string &retiredPath)
+{
+    MappedFile records(this->path);
+
+    auto retiredFd = ::open(retiredPath.c_str(), O_WRONLY | O_APPEND);
+    if (retiredFd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot open journal " + retiredPath);
+
+    auto error = writeAll(retiredFd, records.getBytes().data(), records.getBytes().size());
+    if (error == 0 && ::fdatasync(retiredFd) != 0)
+        error = errno;
+
+    ::close(retiredFd);
+
+    if (error == 0 && ::ftruncate(this->fd, 0) != 0)
+        error = errno;
+
+    if (error != 0)
+        throw std::system_error(error, std::generic_category(), "cannot retire journal " + this->path);
+}
+
+std::span<const JournalRecord> BookingJournal::recordsOf(const MappedFile &file)
+{
+    auto bytes = file.getBytes();
+    return {reinterpret_cast<const JournalRecord *>(bytes.data()), bytes.size() / sizeof(JournalRecord)};
+}
+
+void BookingJournal::run_flusher()
+{
+    std::vector<JournalRecord> batch;
+    std::unique_lock lock(this->lck_pending);
+
+    while (true)
+    {
+        this->cv_flush.wait(lock, [&]
+                            { return this->stop || !this->pending.empty(); });
+
+        if (this->pending.empty())
+            break;
+
+        // Everything appended while the previous batch was synced goes out with a single sync
+        batch.swap(this->pending);
+        auto batchSeq = this->appendedSeq;
+        lock.unlock();
+
+        int error;
+        {
+            std::lock_guard guard_file(this->lck_file);
+
+            error = writeAll(this->fd, batch.data(), batch.size() * sizeof(JournalRecord));
+            if (error == 0 && ::fdatasync(this->fd) != 0)
+                error = errno;
+        }
+
+        batch.clear();
+        lock.lock();
+
+        if (error == 0)
+            this->durableSeq = batchSeq;
+        else
+            this->writeError = error;
+
+        this->cv_durable.notify_all();
+    }
+}
+
+BookingSnapshot::BookingSnapshot(const std::string &path) : file(path)
+{
+    auto bytes = this->file.getBytes();
+    if (bytes.empty())
+        return;
+
+    Header header;
+    if (bytes.size() < sizeof(Header))
+        throw std::runtime_error("not a snapshot: " + path);
+
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.recordSize != sizeof(SnapshotRecord) ||
+        header.noBookings > (bytes.size() - sizeof(Header)) / sizeof(SnapshotRecord))
+        throw std::runtime_error("not a snapshot: " + path);
+
+    this->records = {reinterpret_cast<const SnapshotRecord *>(bytes.data() + sizeof(Header)), header.noBookings};
+}
+
+void BookingSnapshot::write(const std::string &path, std::span<const SnapshotRecord> records)
+{
+    auto tmpPath = path + ".tmp";
+
+    auto fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "cannot create snapshot " + tmpPath);
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.recordSize = sizeof(SnapshotRecord);
+    header.noBookings = records.size();
+
+    auto error = writeAll(fd, &header, sizeof(header));
+    if (error == 0)
+        error = writeAll(fd, records.data(), records.size_bytes());
+    if (error == 0 && ::fsync(fd) != 0)
+        error = errno;
+
+    ::close(fd);
+
+    if (error == 0 && ::rename(tmpPath.c_str(), path.c_str()) != 0)
+        error = errno;
+
+    if (error != 0)
+    {
+        ::unlink(tmpPath.c_str());
+        throw std::system_error(error, std::generic_category(), "cannot write snapshot " + path);
+    }
+}
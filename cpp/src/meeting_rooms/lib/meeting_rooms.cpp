@@ -1,170 +1,1476 @@
 #include <iostream>
+#include <cstdio>
 #include "../include/meeting_rooms.h"
+#include "../include/booking_journal.h"
 
-MeetingRoomScheduler::MeetingRoomScheduler()
+static JournalRecord journalRecordOf(JournalOp op, RoomId roomId, const sys_time<milliseconds> &low, const sys_time<milliseconds> &high)
 {
-    this->cleanupThread = std::thread([this]
-                                      { this->run_cleanup(); });
+    return JournalRecord{op, {}, roomId, low.time_since_epoch().count(), high.time_since_epoch().count()};
 }
 
-MeetingRoomScheduler::~MeetingRoomScheduler()
+// Slot of a journal or snapshot record
+static DateTimeSlot slotOf(int64_t startMs, int64_t endMs)
+{
+    return DateTimeSlot(sys_time<milliseconds>(milliseconds(startMs)), static_cast<unsigned int>(duration_cast<minutes>(milliseconds(endMs - startMs)).count()));
+}
+
+// Sets the bits [first, last) of a bitmap row
+static void setBitRange(uint64_t *row, size_t first, size_t last)
+{
+    while (first < last)
+    {
+        auto bit = first % 64;
+        auto noBits = std::min<size_t>(64 - bit, last - first);
+
+        row[first / 64] |= (noBits == 64 ? ~uint64_t(0) : ((uint64_t(1) << noBits) - 1)) << bit;
+        first += noBits;
+    }
+}
+
+// Blocks of step from `from` up to `to`, the last one possibly shorter
+static size_t gridBlocks(const system_clock::time_point &from, const system_clock::time_point &to, minutes step)
+{
+    auto window = time_point_cast<milliseconds>(to) - time_point_cast<milliseconds>(from);
+    if (window <= milliseconds(0) || step <= minutes(0))
+        return 0;
+
+    return static_cast<size_t>((window + step - milliseconds(1)) / step);
+}
+
+template <typename IndexType, typename ClockType>
+BasicMeetingRoomScheduler<IndexType, ClockType>::BasicMeetingRoomScheduler(ClockType a_clock) : clock(std::move(a_clock))
+{
+    this->materializeSeries();
+
+    if constexpr (!ClockType::IsVirtual)
+        this->cleanupThread = std::thread([this]
+                                          { this->run_cleanup(); });
+}
+
+template <typename IndexType, typename ClockType>
+BasicMeetingRoomScheduler<IndexType, ClockType>::~BasicMeetingRoomScheduler()
 {
     this->stop = true;
     cv_wakeCleanupThread.notify_one();
 
-    this->cleanupThread.join();
+    if (this->cleanupThread.joinable())
+        this->cleanupThread.join();
 }
 
-void MeetingRoomScheduler::registerRoom(const MeetingRoom &m)
+template <typename IndexType, typename ClockType>
+RoomId BasicMeetingRoomScheduler<IndexType, ClockType>::registerRoom(const MeetingRoom &m)
 {
     std::lock_guard guard_write(this->lck_meetingRooms);
-    this->meetingRooms.insert(std::make_pair(m.getName(), m));
+
+    auto [itRoomId, inserted] = this->roomIds.insert(std::make_pair(std::string(m.getName()), static_cast<RoomId>(this->meetingRooms.size())));
+    if (inserted)
+    {
+        this->meetingRooms.push_back(m);
+
+        // After the rooms with as many seats, which have lower ids
+        auto itRank = std::partition_point(this->roomsBySeats.begin(), this->roomsBySeats.end(), [&](RoomId roomId)
+                                           { return this->meetingRooms[roomId].getSeats() <= m.getSeats(); });
+        auto rank = static_cast<size_t>(itRank - this->roomsBySeats.begin());
+
+        this->roomsBySeats.insert(itRank, itRoomId->second);
+        this->seatRanks.push_back(0);
+
+        for (; rank < this->roomsBySeats.size(); rank++)
+            this->seatRanks[this->roomsBySeats[rank]] = static_cast<uint32_t>(rank);
+    }
+
+    return itRoomId->second;
+}
+
+template <typename IndexType, typename ClockType>
+const MeetingRoom &BasicMeetingRoomScheduler<IndexType, ClockType>::getRoom(RoomId roomId)
+{
+    std::shared_lock guard_read(this->lck_meetingRooms);
+    return this->meetingRooms.at(roomId);
+}
+
+template <typename IndexType, typename ClockType>
+int64_t BasicMeetingRoomScheduler<IndexType, ClockType>::dayOf(const IntervalType &time)
+{
+    return floor<days>(time).time_since_epoch().count();
+}
+
+template <typename IndexType, typename ClockType>
+std::shared_lock<std::shared_mutex> BasicMeetingRoomScheduler<IndexType, ClockType>::lockShardsOf(const IntervalType &from, const IntervalType &to, std::vector<BookingShard *> &slotShards)
+{
+    auto firstDay = dayOf(from);
+    auto lastDay = std::max(firstDay, dayOf(to - typename IntervalType::duration(1)));
+
+    do
+    {
+        std::shared_lock guard_shards(this->lck_shards);
+        slotShards.clear();
+
+        for (auto itShard = this->shards.lower_bound(firstDay); itShard != this->shards.end() && itShard->first <= lastDay; itShard++)
+            slotShards.push_back(itShard->second.get());
+
+        if (slotShards.size() == static_cast<size_t>(lastDay - firstDay + 1))
+            return guard_shards;
+
+        guard_shards.unlock();
+
+        // Create the missing days and look them up again, expiry may drop past days in between
+        std::lock_guard guard_write(this->lck_shards);
+        for (auto day = firstDay; day <= lastDay; day++)
+            this->shards.try_emplace(day, std::make_unique<BookingShard>());
+
+    } while (true);
+}
+
+template <typename IndexType, typename ClockType>
+template <typename Fn>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::forEachShardOf(const IntervalType &from, const IntervalType &to, Fn &&fn)
+{
+    auto firstDay = dayOf(from);
+    auto lastDay = std::max(firstDay, dayOf(to - typename IntervalType::duration(1)));
+
+    for (auto itShard = this->shards.lower_bound(firstDay); itShard != this->shards.end() && itShard->first <= lastDay; itShard++)
+        fn(*itShard->second);
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRoom(const DateTimeSlot &ts)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Book);
+
+    auto booking = this->bookAnyRoom(ts);
+    timer.stop(1, booking.has_value());
+
+    return booking;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRoom(const std::string &roomName, const DateTimeSlot &ts)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Book);
+
+    auto booking = this->bookNamedRoom(roomName, ts);
+    timer.stop(1, booking.has_value());
+
+    return booking;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRoom(const DateTimeSlot &ts, size_t minSeats)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Book);
+
+    auto booking = this->bookAnyRoom(ts, minSeats);
+    timer.stop(1, booking.has_value());
+
+    return booking;
 }
 
-std::optional<MeetingRoomBooking> MeetingRoomScheduler::requestRoom(const DateTimeSlot &ts)
-{     
-    auto bookedRoomsInInterval = this->findConflictingRooms(ts);
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::isRoomAvailable(const std::string &roomName, const DateTimeSlot &ts)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Query);
+    bool available = false;
 
     {
         std::shared_lock guard_read(this->lck_meetingRooms);
-        for (auto room : this->meetingRooms)
+
+        if (auto itRoomId = this->roomIds.find(roomName); itRoomId != this->roomIds.end())
         {
-            if (!bookedRoomsInInterval.contains(room.first))
-            {
-                return this->bookRoom(room.second, ts);
-            }
+            auto guard_series = this->lockPendingSeries(ts.getEndTime());
+            available = true;
+
+            if (guard_series.owns_lock())
+                this->forEachPendingOccurrence(ts.getStartTime(), ts.getEndTime(), [&](RoomId roomId, const DateTimeSlot &)
+                                               { available = available && roomId != itRoomId->second; });
+
+            std::shared_lock guard_shards(this->lck_shards);
+
+            this->forEachShardOf(lowOf(ts), highOf(ts), [&](BookingShard &shard)
+                                 { available = available && !shard.index.anyOverlap(lowOf(ts), highOf(ts), itRoomId->second); });
         }
     }
 
-    return std::nullopt;
+    timer.stop(1, available);
+    return available;
+}
+
+template <typename IndexType, typename ClockType>
+template <typename Fn>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::sweepBookingsFrom(IntervalType after, Fn &&sweep)
+{
+    for (auto itShard = this->shards.lower_bound(dayOf(after)); itShard != this->shards.end(); itShard++)
+    {
+        if (!itShard->second->index.forEachOverlapping(after, IntervalType::max(), sweep))
+            return;
+    }
 }
 
-std::optional<MeetingRoomBooking> MeetingRoomScheduler::requestRoom(const std::string &roomName, const DateTimeSlot &ts)
+template <typename IndexType, typename ClockType>
+std::optional<DateTimeSlot> BasicMeetingRoomScheduler<IndexType, ClockType>::findNextFreeSlot(const std::string &roomName, const system_clock::time_point &after,
+                                                                                             unsigned int min_duration)
 {
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Query);
     std::shared_lock guard_read(this->lck_meetingRooms);
 
-    if (auto itMeetingRoom = this->meetingRooms.find(roomName); itMeetingRoom != this->meetingRooms.end())
+    auto itRoomId = this->roomIds.find(roomName);
+    if (itRoomId == this->roomIds.end())
     {
-        if (!this->findConflictingRooms(ts).contains(itMeetingRoom->first))
-            return this->bookRoom(itMeetingRoom->second, ts);
+        timer.stop(1, 0);
+        return std::nullopt;
     }
 
-    return std::nullopt;
-}
+    auto freeFrom = ceil<typename IntervalType::duration>(after);
+    auto length = minutes(min_duration);
 
-std::string timePointToString(const std::chrono::sys_time<milliseconds> &time_point)
-{
-    auto s = duration_cast<seconds>(time_point.time_since_epoch()).count();
-    return std::string(std::ctime(&s));
+    while (true)
+    {
+        {
+            std::shared_lock guard_shards(this->lck_shards);
+
+            // A gap is checked against the shards of every day it reaches into. Bookings of skipped days that overlap the
+            // candidate are also stored in the shard of its day.
+            for (auto itShard = this->shards.lower_bound(dayOf(freeFrom));
+                 itShard != this->shards.end() && itShard->first <= dayOf(freeFrom + length - typename IntervalType::duration(1));
+                 itShard = this->shards.lower_bound(std::max(itShard->first + 1, dayOf(freeFrom))))
+                freeFrom = itShard->second->index.findGap(freeFrom, length, itRoomId->second);
+        }
+
+        // A gap reaching past the materialized occurrences is moved after the room's occurrences still in their rules
+        auto freeTo = timeOf(freeFrom) + length;
+        auto guard_series = this->lockPendingSeries(freeTo);
+        if (!guard_series.owns_lock())
+            break;
+
+        auto busyUntil = timeOf(freeFrom);
+        this->forEachPendingOccurrence(timeOf(freeFrom), freeTo, [&](RoomId roomId, const DateTimeSlot &occurrence)
+                                       {
+                                           if (roomId == itRoomId->second)
+                                               busyUntil = std::max(busyUntil, occurrence.getEndTime()); });
+
+        if (busyUntil == timeOf(freeFrom))
+            break;
+
+        freeFrom = ceil<typename IntervalType::duration>(busyUntil);
+    }
+
+    timer.stop(1, 1);
+    return DateTimeSlot(timeOf(freeFrom), min_duration);
 }
 
-MeetingRoomBooking MeetingRoomScheduler::bookRoom(const MeetingRoom &room, const DateTimeSlot &ts)
+template <typename IndexType, typename ClockType>
+std::optional<FreeSlot> BasicMeetingRoomScheduler<IndexType, ClockType>::findNextFreeSlot(const system_clock::time_point &after, unsigned int min_duration)
 {
-    static auto prevNow = system_clock::now();
-    static int noBookings = 0;
-    static int totalBookings = 0;
-    static bool firstBooking = true;
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Query);
+    std::shared_lock guard_read(this->lck_meetingRooms);
+
+    if (this->meetingRooms.empty())
+    {
+        timer.stop(1, 0);
+        return std::nullopt;
+    }
+
+    thread_local DynamicBitset roomsWithGap;
 
-    auto showNoBookingPerSec = []()
+    // Start of the candidate gap of every room, a room's gap is final once a later booking starts after its end
+    auto start = ceil<typename IntervalType::duration>(after);
+    auto length = minutes(min_duration);
+
+    std::vector<IntervalType> freeFrom;
+    size_t earliestRoom;
+
+    // Candidates by start then room id, a room's older entries are skipped once its candidate moved on
+    using Candidate = std::pair<IntervalType, RoomId>;
+    std::vector<Candidate> candidates;
+
+    auto popEarliestRoom = [&]()
     {
-        if (firstBooking)
+        while (candidates.front().first != freeFrom[candidates.front().second])
         {
-            firstBooking = false;
-            prevNow = system_clock::now();
+            std::pop_heap(candidates.begin(), candidates.end(), std::greater<>());
+            candidates.pop_back();
         }
-        else if ((system_clock::now() - prevNow) > seconds(1))
-        {
-            totalBookings += noBookings;
-            std::cout << noBookings << " bookings/sec | total:  " << totalBookings << std::endl;
 
-            prevNow = system_clock::now();
-            noBookings = 0;
-        }
+        return static_cast<size_t>(candidates.front().second);
     };
 
-    this->iTree.insert({ts.getStartTime(), ts.getEndTime(), room.getName()});
+    freeFrom.assign(this->meetingRooms.size(), start);
 
-    bool restart_cleanup = false;
+    while (true)
     {
-        std::lock_guard lock(this->lck_cleanup);
+        roomsWithGap.reset(this->meetingRooms.size());
+
+        candidates.clear();
+        for (RoomId roomId = 0; roomId < this->meetingRooms.size(); roomId++)
+            candidates.emplace_back(freeFrom[roomId], roomId);
+
+        std::make_heap(candidates.begin(), candidates.end(), std::greater<>());
+        earliestRoom = candidates.front().second;
+
+        std::shared_lock guard_shards(this->lck_shards);
+
+        // Every room's gap starts at or after the earliest candidate, so the sweep ends once that one is final
+        this->sweepBookingsFrom(freeFrom[earliestRoom], [&](const IntervalType &low, const IntervalType &high, const IntervalPayload &roomId)
+                                {
+                                    if (low >= freeFrom[earliestRoom] + length)
+                                        return false;
+
+                                    if (roomsWithGap.test(roomId) || high <= freeFrom[roomId])
+                                        return true;
+
+                                    if (low >= freeFrom[roomId] + length)
+                                    {
+                                        roomsWithGap.set(roomId);
+                                        return roomId != earliestRoom;
+                                    }
+
+                                    freeFrom[roomId] = high;
+
+                                    candidates.emplace_back(high, roomId);
+                                    std::push_heap(candidates.begin(), candidates.end(), std::greater<>());
+
+                                    if (roomId == earliestRoom)
+                                        earliestRoom = popEarliestRoom();
 
-        // Check if current booking ends before previous minimum one
-        restart_cleanup = this->endTimes.size() && ts.getEndTime() < this->endTimes.top();
-        this->endTimes.push(ts.getEndTime());
+                                    return true; });
 
-        noBookings++;
-        showNoBookingPerSec();
+        guard_shards.unlock();
+
+        // A gap reaching past the materialized occurrences is moved after the room's occurrences still in their rules,
+        // then the rooms are swept again from their candidates
+        auto freeTo = timeOf(freeFrom[earliestRoom]) + length;
+        auto guard_series = this->lockPendingSeries(freeTo);
+        if (!guard_series.owns_lock())
+            break;
+
+        auto busyUntil = timeOf(freeFrom[earliestRoom]);
+        this->forEachPendingOccurrence(timeOf(freeFrom[earliestRoom]), freeTo, [&](RoomId roomId, const DateTimeSlot &occurrence)
+                                       {
+                                           if (roomId == earliestRoom)
+                                               busyUntil = std::max(busyUntil, occurrence.getEndTime()); });
+
+        if (busyUntil == timeOf(freeFrom[earliestRoom]))
+            break;
+
+        freeFrom[earliestRoom] = ceil<typename IntervalType::duration>(busyUntil);
     }
 
-    if (restart_cleanup)
+    timer.stop(1, 1);
+    return FreeSlot{static_cast<RoomId>(earliestRoom), DateTimeSlot(timeOf(freeFrom[earliestRoom]), min_duration)};
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::gridRowWords(const system_clock::time_point &from, const system_clock::time_point &to, minutes step)
+{
+    return (gridBlocks(from, to, step) + 63) / 64;
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::availabilityGrid(const system_clock::time_point &from, const system_clock::time_point &to, minutes step,
+                                                                         std::span<uint64_t> grid, unsigned int noThreads)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Query);
+    std::shared_lock guard_read(this->lck_meetingRooms);
+
+    auto noRooms = this->meetingRooms.size();
+    auto noBlocks = gridBlocks(from, to, step);
+    auto rowWords = gridRowWords(from, to, step);
+
+    if (grid.size() < noRooms * rowWords)
     {
-        this->restart = true;
-        cv_wakeCleanupThread.notify_one();
+        timer.stop(1, 0);
+        return 0;
     }
 
-    return MeetingRoomBooking{room, ts};
+    auto windowStart = time_point_cast<milliseconds>(from);
+    auto windowEnd = time_point_cast<milliseconds>(to);
+
+    auto guard_series = this->lockPendingSeries(windowEnd);
+    std::fill_n(grid.begin(), noRooms * rowWords, uint64_t(0));
+
+    // Marks the blocks [firstBlock, lastBlock) overlapped by the bookings, each thread on its own words of every row
+    auto sweepBlocks = [&](size_t firstBlock, size_t lastBlock)
+    {
+        sys_time<milliseconds> sweepStart = windowStart + static_cast<int64_t>(firstBlock) * step;
+        sys_time<milliseconds> sweepEnd = std::min<sys_time<milliseconds>>(windowEnd, windowStart + static_cast<int64_t>(lastBlock) * step);
+
+        auto markBlocks = [&](const IntervalType &low, const IntervalType &high, const IntervalPayload &roomId)
+        {
+            auto bookingStart = std::max(timeOf(low), sweepStart);
+            auto bookingEnd = std::min(timeOf(high), sweepEnd);
+
+            if (bookingStart < bookingEnd)
+                setBitRange(grid.data() + roomId * rowWords, static_cast<size_t>((bookingStart - windowStart) / step),
+                            static_cast<size_t>((bookingEnd - windowStart + step - milliseconds(1)) / step));
+        };
+
+        auto low = floor<typename IntervalType::duration>(sweepStart);
+        auto high = ceil<typename IntervalType::duration>(sweepEnd);
+
+        // Bookings spanning several days are marked again from their later days, setting the same bits
+        std::shared_lock guard_shards(this->lck_shards);
+
+        this->forEachShardOf(low, high, [&](BookingShard &shard)
+                             { shard.index.forEachOverlapping(low, high, markBlocks); });
+    };
+
+    auto noChunks = std::clamp<size_t>(noThreads, 1, std::max<size_t>(rowWords, 1));
+
+    if (noChunks == 1)
+        sweepBlocks(0, noBlocks);
+    else
+    {
+        auto chunkBlocks = (rowWords + noChunks - 1) / noChunks * 64;
+
+        std::vector<std::thread> threads;
+        for (size_t firstBlock = chunkBlocks; firstBlock < noBlocks; firstBlock += chunkBlocks)
+            threads.emplace_back(sweepBlocks, firstBlock, std::min(noBlocks, firstBlock + chunkBlocks));
+
+        sweepBlocks(0, std::min(noBlocks, chunkBlocks));
+
+        for (auto &thread : threads)
+            thread.join();
+    }
+
+    // Occurrences past the materialized ones are marked from their rules
+    if (guard_series.owns_lock())
+        this->forEachPendingOccurrence(windowStart, windowEnd, [&](RoomId roomId, const DateTimeSlot &occurrence)
+                                       {
+                                           auto bookingStart = std::max(occurrence.getStartTime(), windowStart);
+                                           auto bookingEnd = std::min(occurrence.getEndTime(), windowEnd);
+
+                                           setBitRange(grid.data() + roomId * rowWords, static_cast<size_t>((bookingStart - windowStart) / step),
+                                                       static_cast<size_t>((bookingEnd - windowStart + step - milliseconds(1)) / step)); });
+
+    timer.stop(1, 1);
+    return noRooms;
 }
 
-std::set<std::string_view> MeetingRoomScheduler::findConflictingRooms(const DateTimeSlot &ts)
+template <typename IndexType, typename ClockType>
+SchedulerStats BasicMeetingRoomScheduler<IndexType, ClockType>::stats() const
 {
-    std::set<std::string_view> conflictingRoomNames;
+    return this->metrics.stats();
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::bookAnyRoom(const DateTimeSlot &ts, std::optional<size_t> minSeats)
+{
+    // Reused across requests of the same thread so that the conflict check does not allocate
+    thread_local DynamicBitset bookedRoomsInInterval;
+    thread_local std::vector<BookingShard *> slotShards;
+
+    std::shared_lock guard_read(this->lck_meetingRooms);
+    bookedRoomsInInterval.reset(this->meetingRooms.size());
+
+    // With minSeats booked rooms are marked by seat rank and the search starts at the first room large enough
+    size_t firstCandidate = 0;
+    if (minSeats.has_value())
+    {
+        firstCandidate = static_cast<size_t>(std::partition_point(this->roomsBySeats.begin(), this->roomsBySeats.end(), [&](RoomId roomId)
+                                                                  { return this->meetingRooms[roomId].getSeats() < minSeats.value(); }) -
+                                             this->roomsBySeats.begin());
+    }
+
+    auto markBookedRoom = [&](const IntervalType &, const IntervalType &, const IntervalPayload &roomId)
+    { bookedRoomsInInterval.set(minSeats.has_value() ? this->seatRanks[roomId] : roomId); };
+
+    auto selectFreeRoom = [&]() -> std::optional<IntervalPayload>
+    {
+        auto pos = bookedRoomsInInterval.findFirstZero(firstCandidate);
+        if (pos == DynamicBitset::npos)
+            return std::nullopt;
+
+        return minSeats.has_value() ? this->roomsBySeats[pos] : static_cast<IntervalPayload>(pos);
+    };
+
+    // Held until the booking is inserted, so that no series can take the room meanwhile
+    auto guard_series = this->lockPendingSeries(ts.getEndTime());
+    if (guard_series.owns_lock())
+        this->forEachPendingOccurrence(ts.getStartTime(), ts.getEndTime(), [&](RoomId roomId, const DateTimeSlot &)
+                                       { markBookedRoom(lowOf(ts), highOf(ts), roomId); });
+
+    auto guard_shards = this->lockShardsOf(lowOf(ts), highOf(ts), slotShards);
+    std::optional<IntervalPayload> freeRoomId;
+
+    if (slotShards.size() == 1)
+    {
+        std::shared_lock guard_shard(slotShards.front()->lck_shard);
 
-    for (auto overlappingInterval : this->iTree.getOverlappingIntervalsWith(ts.getStartTime(), ts.getEndTime()))
+        // Conflicts are collected and the free room booked under the same tree lock so no other thread can take it in between
+        freeRoomId = slotShards.front()->index.tryInsertSelected(lowOf(ts), highOf(ts), markBookedRoom, selectFreeRoom);
+    }
+    else
     {
-        conflictingRoomNames.insert(overlappingInterval.payload);
+        std::vector<std::unique_lock<std::shared_mutex>> guard_slotShards;
+        for (auto shard : slotShards)
+            guard_slotShards.emplace_back(shard->lck_shard);
+
+        for (auto shard : slotShards)
+            shard->index.forEachOverlapping(lowOf(ts), highOf(ts), markBookedRoom);
+
+        freeRoomId = selectFreeRoom();
+        if (freeRoomId.has_value())
+        {
+            for (auto shard : slotShards)
+                shard->index.insert({lowOf(ts), highOf(ts), freeRoomId.value()});
+        }
     }
 
-    return conflictingRoomNames;
+    if (!freeRoomId.has_value())
+        return std::nullopt;
+
+    return this->bookRoom(freeRoomId.value(), ts);
 }
 
-void MeetingRoomScheduler::cancelBooking(const MeetingRoomBooking &booking)
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::bookNamedRoom(const std::string &roomName, const DateTimeSlot &ts)
 {
-    this->iTree.remove({booking.timeSlot.getStartTime(), booking.timeSlot.getEndTime(), booking.meetingRoom.getName()});
+    std::shared_lock guard_read(this->lck_meetingRooms);
+
+    auto itRoomId = this->roomIds.find(roomName);
+    if (itRoomId == this->roomIds.end())
+        return std::nullopt;
+
+    bool pendingConflict = false;
+    auto guard_series = this->lockPendingSeries(ts.getEndTime());
+
+    if (guard_series.owns_lock())
+        this->forEachPendingOccurrence(ts.getStartTime(), ts.getEndTime(), [&](RoomId roomId, const DateTimeSlot &)
+                                       { pendingConflict = pendingConflict || roomId == itRoomId->second; });
+
+    if (pendingConflict || !this->tryInsertBooking({lowOf(ts), highOf(ts), itRoomId->second}))
+        return std::nullopt;
+
+    return this->bookRoom(itRoomId->second, ts);
 }
 
-void MeetingRoomScheduler::run_cleanup()
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::tryInsertBooking(const typename IndexType::Data &booking)
 {
-    auto removeExpiredBookingsTill = [this](IntervalType tillEndTime)
+    thread_local std::vector<BookingShard *> slotShards;
+
+    auto guard_shards = this->lockShardsOf(booking.low, booking.high, slotShards);
+
+    if (slotShards.size() == 1)
+    {
+        std::shared_lock guard_shard(slotShards.front()->lck_shard);
+
+        if (!slotShards.front()->index.tryInsertIfNoPayloadOverlap(booking))
+            return false;
+    }
+    else
     {
-        for (auto booking : this->iTree.getIntervalsEndingBefore(tillEndTime))
+        std::vector<std::unique_lock<std::shared_mutex>> guard_slotShards;
+        for (auto shard : slotShards)
+            guard_slotShards.emplace_back(shard->lck_shard);
+
+        for (auto shard : slotShards)
         {
-            this->iTree.remove(booking);
+            if (shard->index.anyOverlap(booking.low, booking.high, booking.payload))
+                return false;
         }
-    };
 
-    do
+        for (auto shard : slotShards)
+            shard->index.insert(booking);
+    }
+
+    return true;
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::removeBooking(const typename IndexType::Data &booking)
+{
+    std::shared_lock guard_shards(this->lck_shards);
+
+    this->forEachShardOf(booking.low, booking.high, [&](BookingShard &shard)
+                         { shard.index.remove(booking); });
+}
+
+template <typename IndexType, typename ClockType>
+std::vector<std::optional<MeetingRoomBooking>> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRooms(std::span<const DateTimeSlot> slots)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::BookBatch);
+
+    std::vector<std::optional<MeetingRoomBooking>> bookings(slots.size());
+    if (slots.empty())
+        return bookings;
+
+    thread_local DynamicBitset bookedRoomsInInterval;
+    thread_local std::vector<BookingShard *> batchShards;
+
+    // Slot positions in start order
+    std::vector<size_t> order(slots.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+              { return slots[a].getStartTime() < slots[b].getStartTime(); });
+
+    auto batchEnd = highOf(*std::max_element(slots.begin(), slots.end(), [](const DateTimeSlot &a, const DateTimeSlot &b)
+                                             { return a.getEndTime() < b.getEndTime(); }));
+    auto batchStart = lowOf(slots[order.front()]);
+
+    std::shared_lock guard_read(this->lck_meetingRooms);
+    auto guard_series = this->lockPendingSeries(timeOf(batchEnd));
+
+    // The shards of every day of the batch are locked once for the whole sweep
+    auto guard_shards = this->lockShardsOf(batchStart, std::max(batchEnd, batchStart + typename IntervalType::duration(1)), batchShards);
+    auto firstDay = dayOf(batchStart);
+
+    std::vector<std::unique_lock<std::shared_mutex>> guard_batchShards;
+    for (auto shard : batchShards)
+        guard_batchShards.emplace_back(shard->lck_shard);
+
+    // Accepted bookings of the batch that may still overlap the next slots, as a min heap on their end
+    struct AcceptedBooking
     {
-        auto now = system_clock::now();
-        auto cleanup_required = false;
+        IntervalType low;
+        IntervalType high;
+        RoomId roomId;
+    };
+
+    auto endsLater = [](const AcceptedBooking &a, const AcceptedBooking &b)
+    { return a.high > b.high; };
+
+    std::vector<AcceptedBooking> activeBookings;
+    std::vector<std::vector<typename IndexType::Data>> acceptedPerShard(batchShards.size());
+
+    auto markBookedRoom = [&](const IntervalType &, const IntervalType &, const IntervalPayload &roomId)
+    { bookedRoomsInInterval.set(roomId); };
 
-        std::unique_lock lock(this->lck_cleanup);
+    for (auto pos : order)
+    {
+        auto startTime = lowOf(slots[pos]), endTime = highOf(slots[pos]);
 
-        while (this->endTimes.size() > 0 && this->endTimes.top() <= now)
+        while (!activeBookings.empty() && activeBookings.front().high <= startTime)
         {
-            this->endTimes.pop();
-            cleanup_required = true;
+            std::pop_heap(activeBookings.begin(), activeBookings.end(), endsLater);
+            activeBookings.pop_back();
         }
 
-        if (cleanup_required)
+        bookedRoomsInInterval.reset(this->meetingRooms.size());
+
+        for (const auto &active : activeBookings)
         {
-            removeExpiredBookingsTill(time_point_cast<std::chrono::milliseconds>(now));
+            if (active.low < endTime)
+                bookedRoomsInInterval.set(active.roomId);
         }
 
-        auto timeLeftTillNextBookingEnds = this->endTimes.size() == 0 ? nanoseconds(hours(1)) : this->endTimes.top() - now;
+        auto slotFirstShard = static_cast<size_t>(dayOf(startTime) - firstDay);
+        auto slotLastShard = static_cast<size_t>(std::max(dayOf(startTime), dayOf(endTime - typename IntervalType::duration(1))) - firstDay);
+
+        for (auto shard = slotFirstShard; shard <= slotLastShard; shard++)
+            batchShards[shard]->index.forEachOverlapping(startTime, endTime, markBookedRoom);
+
+        if (guard_series.owns_lock())
+            this->forEachPendingOccurrence(slots[pos].getStartTime(), slots[pos].getEndTime(), [&](RoomId bookedRoomId, const DateTimeSlot &)
+                                           { bookedRoomsInInterval.set(bookedRoomId); });
+
+        auto roomId = bookedRoomsInInterval.findFirstZero();
+        if (roomId == DynamicBitset::npos)
+            continue;
+
+        for (auto shard = slotFirstShard; shard <= slotLastShard; shard++)
+            acceptedPerShard[shard].push_back({startTime, endTime, static_cast<RoomId>(roomId)});
+
+        activeBookings.push_back({startTime, endTime, static_cast<RoomId>(roomId)});
+        std::push_heap(activeBookings.begin(), activeBookings.end(), endsLater);
+
+        bookings[pos] = MeetingRoomBooking{static_cast<RoomId>(roomId), slots[pos]};
+    }
+
+    for (size_t shard = 0; shard < batchShards.size(); shard++)
+    {
+        if (!acceptedPerShard[shard].empty())
+            batchShards[shard]->index.insertAll(acceptedPerShard[shard]);
+    }
 
-        auto waitRes = cv_wakeCleanupThread.wait_for(lock, timeLeftTillNextBookingEnds, [&]
-                                                     { return this->stop || this->restart; });
+    guard_batchShards.clear();
+    guard_shards.unlock();
+
+    if (guard_series.owns_lock())
+        guard_series.unlock();
+
+    bool restart_cleanup = false;
+    uint64_t noBooked = 0;
+    uint64_t seq = 0;
+    {
+        std::lock_guard lock(this->lck_cleanup);
 
-        if (!waitRes) // timeout expired
+        for (auto &booking : bookings)
         {
-            removeExpiredBookingsTill(this->endTimes.top());
-            this->endTimes.pop();
+            if (booking.has_value())
+            {
+                booking->handle = this->scheduleExpiry(booking->roomId, booking->timeSlot, restart_cleanup);
+                noBooked++;
+
+                if (this->journal != nullptr)
+                    seq = this->journal->append(journalRecordOf(JournalOp::Book, booking->roomId, booking->timeSlot.getStartTime(), booking->timeSlot.getEndTime()));
+            }
         }
+    }
 
-        this->restart = false;
+    if (restart_cleanup)
+        this->restartCleanup();
 
-        if (this->stop)
-            break;
+    // The batch waits for a single sync
+    if (seq != 0)
+        this->journal->waitDurable(seq);
 
-    } while (true);
-}
\ No newline at end of file
+    timer.stop(slots.size(), noBooked);
+    return bookings;
+}
+
+std::string timePointToString(const std::chrono::sys_time<milliseconds> &time_point)
+{
+    auto s = duration_cast<seconds>(time_point.time_since_epoch()).count();
+    return std::string(std::ctime(&s));
+}
+
+template <typename IndexType, typename ClockType>
+MeetingRoomBooking BasicMeetingRoomScheduler<IndexType, ClockType>::bookRoom(RoomId roomId, const DateTimeSlot &ts)
+{
+    bool restart_cleanup = false;
+    BookingHandle handle;
+    uint64_t seq = 0;
+    {
+        std::lock_guard lock(this->lck_cleanup);
+        handle = this->scheduleExpiry(roomId, ts, restart_cleanup);
+
+        // Appended with the booking entry, before the booking can be cancelled
+        if (this->journal != nullptr)
+            seq = this->journal->append(journalRecordOf(JournalOp::Book, roomId, ts.getStartTime(), ts.getEndTime()));
+    }
+
+    if (restart_cleanup)
+        this->restartCleanup();
+
+    if (seq != 0)
+        this->journal->waitDurable(seq);
+
+    return MeetingRoomBooking{roomId, ts, handle};
+}
+
+template <typename IndexType, typename ClockType>
+BookingHandle BasicMeetingRoomScheduler<IndexType, ClockType>::scheduleExpiry(RoomId roomId, const DateTimeSlot &ts, bool &restart_cleanup)
+{
+    auto endTime = ts.getEndTime();
+
+    uint32_t id;
+    if (this->freeBookingEntries.empty())
+    {
+        id = static_cast<uint32_t>(this->bookingEntries.size());
+        this->bookingEntries.emplace_back();
+    }
+    else
+    {
+        id = this->freeBookingEntries.back();
+        this->freeBookingEntries.pop_back();
+    }
+
+    auto &entry = this->bookingEntries[id];
+    entry.interval = {lowOf(ts), highOf(ts), roomId};
+    entry.expiry = this->expiryWheel.schedule(endTime.time_since_epoch().count(), id);
+    entry.booked = true;
+
+    this->bookingIds.emplace(entry.interval, id);
+
+    // Only a booking ending before the armed wakeup restarts the cleanup thread, later ones are picked up on the way.
+    // Bookings that ended before the last cleanup pass are left to the next one.
+    if (endTime < this->cleanupWakeupTime && endTime.time_since_epoch().count() > this->expiryWheel.getTime())
+    {
+        this->cleanupWakeupTime = endTime;
+        restart_cleanup = true;
+    }
+
+    return BookingHandle{id, entry.generation};
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::releaseBooking(uint32_t id)
+{
+    auto &entry = this->bookingEntries[id];
+    entry.booked = false;
+
+    auto [first, last] = this->bookingIds.equal_range(entry.interval);
+    for (auto itId = first; itId != last; itId++)
+    {
+        if (itId->second == id)
+        {
+            this->bookingIds.erase(itId);
+            break;
+        }
+    }
+
+    // Generation 0 marks bookings without a handle
+    if (++entry.generation == 0)
+        entry.generation = 1;
+
+    this->freeBookingEntries.push_back(id);
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::restartCleanup()
+{
+    this->restart = true;
+    cv_wakeCleanupThread.notify_one();
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::cancelBooking(const MeetingRoomBooking &booking)
+{
+    if (booking.handle.isValid())
+        return this->cancelBooking(booking.handle);
+
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Cancel);
+    std::shared_lock guard_rotate(this->lck_rotate);
+
+    std::optional<typename IndexType::Data> interval;
+    uint64_t seq;
+    {
+        std::lock_guard lock(this->lck_cleanup);
+
+        interval = this->unbook({lowOf(booking.timeSlot), highOf(booking.timeSlot), booking.roomId});
+        seq = this->appendCancelRecord(interval);
+    }
+
+    return this->removeCancelledBooking(interval, seq, timer);
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::cancelBooking(BookingHandle handle)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Cancel);
+    std::shared_lock guard_rotate(this->lck_rotate);
+
+    std::optional<typename IndexType::Data> interval;
+    uint64_t seq;
+    {
+        std::lock_guard lock(this->lck_cleanup);
+
+        if (handle.id < this->bookingEntries.size() && this->bookingEntries[handle.id].booked && this->bookingEntries[handle.id].generation == handle.generation)
+            interval = this->unbook(handle.id);
+
+        seq = this->appendCancelRecord(interval);
+    }
+
+    return this->removeCancelledBooking(interval, seq, timer);
+}
+
+template <typename IndexType, typename ClockType>
+typename IndexType::Data BasicMeetingRoomScheduler<IndexType, ClockType>::unbook(uint32_t id)
+{
+    auto interval = this->bookingEntries[id].interval;
+
+    this->expiryWheel.cancel(this->bookingEntries[id].expiry);
+    this->releaseBooking(id);
+
+    return interval;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<typename IndexType::Data> BasicMeetingRoomScheduler<IndexType, ClockType>::unbook(const typename IndexType::Data &interval)
+{
+    auto itId = this->bookingIds.find(interval);
+    if (itId == this->bookingIds.end())
+        return std::nullopt;
+
+    return this->unbook(itId->second);
+}
+
+template <typename IndexType, typename ClockType>
+uint64_t BasicMeetingRoomScheduler<IndexType, ClockType>::appendCancelRecord(const std::optional<typename IndexType::Data> &interval)
+{
+    if (this->journal == nullptr || !interval.has_value())
+        return 0;
+
+    return this->journal->append(journalRecordOf(JournalOp::Cancel, interval->payload, timeOf(interval->low), timeOf(interval->high)));
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::removeCancelledBooking(const std::optional<typename IndexType::Data> &interval, uint64_t seq,
+                                                                             SchedulerMetrics::Timer &timer)
+{
+    if (!interval.has_value())
+    {
+        timer.stop(1, 0);
+        return false;
+    }
+
+    this->removeBooking(interval.value());
+
+    if (seq != 0)
+        this->journal->waitDurable(seq);
+
+    timer.stop(1, 1);
+    return true;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<RecurringBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRecurringRoom(const std::string &roomName, const RecurrenceRule &rule)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Book);
+    std::optional<RecurringBooking> booking;
+
+    {
+        std::shared_lock guard_read(this->lck_meetingRooms);
+
+        if (auto itRoomId = this->roomIds.find(roomName); itRoomId != this->roomIds.end())
+            booking = this->bookSeries(rule, itRoomId->second);
+    }
+
+    timer.stop(1, booking.has_value());
+    return booking;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<RecurringBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::requestRecurringRoom(const RecurrenceRule &rule)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Book);
+    std::optional<RecurringBooking> booking;
+
+    {
+        std::shared_lock guard_read(this->lck_meetingRooms);
+        booking = this->bookSeries(rule, std::nullopt);
+    }
+
+    timer.stop(1, booking.has_value());
+    return booking;
+}
+
+template <typename IndexType, typename ClockType>
+std::shared_lock<std::shared_mutex> BasicMeetingRoomScheduler<IndexType, ClockType>::lockPendingSeries(const sys_time<milliseconds> &end)
+{
+    // The horizon only moves on, an end within it stays within
+    if (end.time_since_epoch().count() <= this->seriesMaterializedUntil.load(std::memory_order_acquire))
+        return {};
+
+    return std::shared_lock(this->lck_series);
+}
+
+template <typename IndexType, typename ClockType>
+template <typename Fn>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::forEachPendingOccurrence(const sys_time<milliseconds> &low, const sys_time<milliseconds> &high, Fn &&fn)
+{
+    for (const auto &series : this->series)
+    {
+        if (!series.active)
+            continue;
+
+        auto first = series.rule.firstSlot.getStartTime();
+        auto length = series.rule.firstSlot.getLength();
+
+        // First occurrence ending after low, found without walking the earlier ones
+        auto beforeLow = low - length - first;
+        int64_t index = beforeLow < milliseconds(0) ? 0 : beforeLow / series.rule.period + 1;
+
+        for (index = std::max<int64_t>(index, series.noMaterialized); index < series.rule.count && first + index * series.rule.period < high; index++)
+        {
+            if (!series.cancelled[index])
+                fn(series.roomId, series.rule.occurrence(static_cast<uint32_t>(index)));
+        }
+    }
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<RecurringBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::bookSeries(const RecurrenceRule &rule, std::optional<RoomId> roomId)
+{
+    if (rule.count == 0 || rule.period <= minutes(0) || rule.period < rule.firstSlot.getLength())
+        return std::nullopt;
+
+    thread_local DynamicBitset bookedRooms;
+    bookedRooms.reset(this->meetingRooms.size());
+
+    // The occurrences within the horizon are inserted with the series
+    this->materializeSeries();
+
+    std::lock_guard guard_series(this->lck_series);
+    auto materializedUntil = sys_time<milliseconds>(milliseconds(this->seriesMaterializedUntil.load(std::memory_order_relaxed)));
+
+    auto markBookedRoom = [&](const IntervalType &, const IntervalType &, const IntervalPayload &bookedRoomId)
+    { bookedRooms.set(bookedRoomId); };
+
+    // One pass over the occurrences in time order, against the stored bookings and the occurrences of other series not
+    // in the index yet. Beyond the horizon no other booking can be added meanwhile, those hold lck_series shared.
+    {
+        std::shared_lock guard_shards(this->lck_shards);
+
+        for (uint32_t index = 0; index < rule.count; index++)
+        {
+            auto ts = rule.occurrence(index);
+
+            this->forEachShardOf(lowOf(ts), highOf(ts), [&](BookingShard &shard)
+                                 { shard.index.forEachOverlapping(lowOf(ts), highOf(ts), markBookedRoom); });
+
+            if (ts.getEndTime() > materializedUntil)
+                this->forEachPendingOccurrence(ts.getStartTime(), ts.getEndTime(), [&](RoomId bookedRoomId, const DateTimeSlot &)
+                                               { bookedRooms.set(bookedRoomId); });
+        }
+    }
+
+    uint32_t noMaterialized = 0;
+    while (noMaterialized < rule.count && rule.occurrence(noMaterialized).getStartTime() < materializedUntil)
+        noMaterialized++;
+
+    // Occurrences within the horizon may still be taken by concurrent bookings, they are inserted with the conflict
+    // check and the room given up if one of them fails
+    auto insertOccurrences = [&](RoomId candidate)
+    {
+        for (uint32_t index = 0; index < noMaterialized; index++)
+        {
+            auto ts = rule.occurrence(index);
+
+            if (!this->tryInsertBooking({lowOf(ts), highOf(ts), candidate}))
+            {
+                while (index-- > 0)
+                    this->removeBooking({lowOf(rule.occurrence(index)), highOf(rule.occurrence(index)), candidate});
+
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    auto candidate = roomId.has_value() ? (bookedRooms.test(roomId.value()) ? DynamicBitset::npos : roomId.value()) : bookedRooms.findFirstZero();
+
+    while (candidate != DynamicBitset::npos && !insertOccurrences(static_cast<RoomId>(candidate)))
+        candidate = roomId.has_value() ? DynamicBitset::npos : bookedRooms.findFirstZero(candidate + 1);
+
+    if (candidate == DynamicBitset::npos)
+        return std::nullopt;
+
+    uint32_t id;
+    if (this->freeSeries.empty())
+    {
+        id = static_cast<uint32_t>(this->series.size());
+        this->series.emplace_back();
+    }
+    else
+    {
+        id = this->freeSeries.back();
+        this->freeSeries.pop_back();
+    }
+
+    auto &series = this->series[id];
+    series.rule = rule;
+    series.roomId = static_cast<RoomId>(candidate);
+    series.noMaterialized = noMaterialized;
+    series.cancelled.assign(rule.count, false);
+    series.active = true;
+
+    return RecurringBooking{series.roomId, rule, SeriesHandle{id, series.generation}};
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::materializeSeries()
+{
+    // Whole days, so that it moves on once a day
+    auto now = this->clock.now();
+    sys_time<milliseconds> target = ceil<days>(now + SeriesHorizon);
+
+    if (target.time_since_epoch().count() <= this->seriesMaterializedUntil.load(std::memory_order_acquire))
+        return false;
+
+    std::lock_guard guard_series(this->lck_series);
+
+    if (target.time_since_epoch().count() <= this->seriesMaterializedUntil.load(std::memory_order_relaxed))
+        return false;
+
+    thread_local std::vector<BookingShard *> slotShards;
+
+    for (uint32_t id = 0; id < this->series.size(); id++)
+    {
+        auto &series = this->series[id];
+        if (!series.active)
+            continue;
+
+        // Conflicts were ruled out when the series was booked, and bookings past the horizon checked the rule since
+        for (; series.noMaterialized < series.rule.count; series.noMaterialized++)
+        {
+            auto ts = series.rule.occurrence(series.noMaterialized);
+            if (ts.getStartTime() >= target)
+                break;
+
+            if (series.cancelled[series.noMaterialized])
+                continue;
+
+            typename IndexType::Data booking{lowOf(ts), highOf(ts), series.roomId};
+            auto guard_shards = this->lockShardsOf(booking.low, booking.high, slotShards);
+
+            for (auto shard : slotShards)
+            {
+                std::shared_lock guard_shard(shard->lck_shard);
+                shard->index.insert(booking);
+            }
+        }
+
+        // Series whose last occurrence is over release their handle
+        if (series.noMaterialized == series.rule.count && series.rule.occurrence(series.rule.count - 1).getEndTime() <= now)
+        {
+            series.active = false;
+            series.cancelled.clear();
+
+            if (++series.generation == 0)
+                series.generation = 1;
+
+            this->freeSeries.push_back(id);
+        }
+    }
+
+    this->seriesMaterializedUntil.store(target.time_since_epoch().count(), std::memory_order_release);
+    return true;
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::cancelSeries(SeriesHandle handle)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Cancel);
+    std::lock_guard guard_series(this->lck_series);
+
+    if (handle.id >= this->series.size() || !this->series[handle.id].active || this->series[handle.id].generation != handle.generation)
+    {
+        timer.stop(1, 0);
+        return false;
+    }
+
+    auto &series = this->series[handle.id];
+    auto now = this->clock.now();
+
+    // Only the inserted occurrences are in the index, the past ones are left to expiry
+    for (uint32_t index = 0; index < series.noMaterialized; index++)
+    {
+        auto ts = series.rule.occurrence(index);
+        if (!series.cancelled[index] && ts.getEndTime() > now)
+            this->removeBooking({lowOf(ts), highOf(ts), series.roomId});
+    }
+
+    series.active = false;
+    series.cancelled.clear();
+
+    if (++series.generation == 0)
+        series.generation = 1;
+
+    this->freeSeries.push_back(handle.id);
+
+    timer.stop(1, 1);
+    return true;
+}
+
+template <typename IndexType, typename ClockType>
+bool BasicMeetingRoomScheduler<IndexType, ClockType>::cancelOccurrence(SeriesHandle handle, uint32_t index)
+{
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Cancel);
+    std::lock_guard guard_series(this->lck_series);
+
+    if (handle.id >= this->series.size() || !this->series[handle.id].active || this->series[handle.id].generation != handle.generation ||
+        index >= this->series[handle.id].rule.count || this->series[handle.id].cancelled[index])
+    {
+        timer.stop(1, 0);
+        return false;
+    }
+
+    auto &series = this->series[handle.id];
+    series.cancelled[index] = true;
+
+    if (index < series.noMaterialized)
+    {
+        auto ts = series.rule.occurrence(index);
+        this->removeBooking({lowOf(ts), highOf(ts), series.roomId});
+    }
+
+    timer.stop(1, 1);
+    return true;
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::importBookings(std::span<const MeetingRoomBooking> bookings, bool sortInParallel)
+{
+    return this->loadBookings(bookings, sortInParallel, true);
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::loadBookings(std::span<const MeetingRoomBooking> bookings, bool sortInParallel, bool journaled)
+{
+    std::shared_lock guard_read(this->lck_meetingRooms);
+
+    // Intervals of every day shard, a booking goes to each day it spans
+    std::map<int64_t, std::vector<typename IndexType::Data>> shardIntervals;
+    size_t noImported = 0;
+
+    for (const auto &booking : bookings)
+    {
+        if (booking.roomId >= this->meetingRooms.size())
+            continue;
+
+        auto startTime = lowOf(booking.timeSlot), endTime = highOf(booking.timeSlot);
+        auto lastDay = std::max(dayOf(startTime), dayOf(endTime - typename IntervalType::duration(1)));
+
+        for (auto day = dayOf(startTime); day <= lastDay; day++)
+            shardIntervals[day].push_back({startTime, endTime, booking.roomId});
+
+        noImported++;
+    }
+
+    {
+        std::lock_guard guard_write(this->lck_shards);
+
+        for (auto &[day, intervals] : shardIntervals)
+        {
+            auto &shard = this->shards.try_emplace(day, std::make_unique<BookingShard>()).first->second;
+            shard->index.bulkLoad(intervals, sortInParallel);
+        }
+    }
+
+    bool restart_cleanup = false;
+    uint64_t seq = 0;
+    {
+        std::lock_guard lock(this->lck_cleanup);
+
+        for (const auto &booking : bookings)
+        {
+            if (booking.roomId >= this->meetingRooms.size())
+                continue;
+
+            this->scheduleExpiry(booking.roomId, booking.timeSlot, restart_cleanup);
+
+            if (journaled && this->journal != nullptr)
+                seq = this->journal->append(journalRecordOf(JournalOp::Book, booking.roomId, booking.timeSlot.getStartTime(), booking.timeSlot.getEndTime()));
+        }
+    }
+
+    if (restart_cleanup)
+        this->restartCleanup();
+
+    if (seq != 0)
+        this->journal->waitDurable(seq);
+
+    return noImported;
+}
+
+template <typename IndexType, typename ClockType>
+std::optional<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::findBooking(RoomId roomId, const DateTimeSlot &ts)
+{
+    std::lock_guard lock(this->lck_cleanup);
+
+    auto itId = this->bookingIds.find(typename IndexType::Data{lowOf(ts), highOf(ts), roomId});
+    if (itId == this->bookingIds.end())
+        return std::nullopt;
+
+    return MeetingRoomBooking{roomId, ts, BookingHandle{itId->second, this->bookingEntries[itId->second].generation}};
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::attachJournal(BookingJournal *a_journal)
+{
+    this->journal = a_journal;
+}
+
+template <typename IndexType, typename ClockType>
+std::vector<MeetingRoomBooking> BasicMeetingRoomScheduler<IndexType, ClockType>::exportBookings()
+{
+    std::vector<MeetingRoomBooking> bookings;
+
+    this->forEachStoredBooking([&](const IntervalType &low, const IntervalType &high, const IntervalPayload &roomId)
+                               { bookings.push_back({roomId, DateTimeSlot(timeOf(low), static_cast<unsigned int>(duration_cast<minutes>(high - low).count()))}); });
+
+    return bookings;
+}
+
+template <typename IndexType, typename ClockType>
+template <typename Fn>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::forEachStoredBooking(Fn &&fn)
+{
+    std::shared_lock guard_shards(this->lck_shards);
+
+    if (this->shards.empty())
+        return;
+
+    auto firstDay = this->shards.begin()->first;
+
+    for (auto itShard = this->shards.begin(); itShard != this->shards.end(); itShard++)
+    {
+        auto day = itShard->first;
+
+        // A booking spanning several days is exported from the first of its days still stored
+        itShard->second->index.forEachOverlapping(IntervalType::min(), IntervalType::max(), [&](const IntervalType &low, const IntervalType &high, const IntervalPayload &roomId)
+                                                  {
+                                                      if (dayOf(low) == day || (day == firstDay && dayOf(low) < day))
+                                                          fn(low, high, roomId); });
+    }
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::writeSnapshot(const std::string &snapshotPath)
+{
+    // Operations journaled before the rotation were applied before the export, so the snapshot covers the retired records:
+    // bookings are journaled once inserted, cancellations hold lck_rotate until their booking is removed
+    if (this->journal != nullptr)
+    {
+        std::lock_guard guard_rotate(this->lck_rotate);
+        this->journal->rotate();
+    }
+
+    std::vector<SnapshotRecord> records;
+
+    this->forEachStoredBooking([&](const IntervalType &low, const IntervalType &high, const IntervalPayload &roomId)
+                               { records.push_back(SnapshotRecord{roomId, 0, timeOf(low).time_since_epoch().count(), timeOf(high).time_since_epoch().count()}); });
+
+    BookingSnapshot::write(snapshotPath, records);
+
+    if (this->journal != nullptr)
+        std::remove(BookingJournal::retiredPathOf(this->journal->getPath()).c_str());
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::recover(const std::string &snapshotPath, const std::string &journalPath)
+{
+    size_t noRecovered = 0;
+
+    {
+        BookingSnapshot snapshot(snapshotPath);
+
+        std::vector<MeetingRoomBooking> bookings;
+        bookings.reserve(snapshot.getRecords().size());
+
+        for (const auto &record : snapshot.getRecords())
+            bookings.push_back({record.roomId, slotOf(record.startMs, record.endMs)});
+
+        noRecovered += this->loadBookings(bookings, true, false);
+    }
+
+    std::shared_lock guard_read(this->lck_meetingRooms);
+    bool restart_cleanup = false;
+
+    // Records are applied to the shards and booking entries by room id, without being journaled again. They may repeat
+    // what the snapshot already holds: bookings conflicting with stored ones are skipped and cancellations of bookings
+    // that are not stored do nothing.
+    for (const auto &path : {BookingJournal::retiredPathOf(journalPath), journalPath})
+    {
+        MappedFile file(path);
+
+        for (const auto &record : BookingJournal::recordsOf(file))
+        {
+            if (record.roomId >= this->meetingRooms.size())
+                continue;
+
+            auto slot = slotOf(record.startMs, record.endMs);
+            typename IndexType::Data booking{lowOf(slot), highOf(slot), record.roomId};
+
+            if (record.op == JournalOp::Book)
+            {
+                if (!this->tryInsertBooking(booking))
+                    continue;
+
+                std::lock_guard lock(this->lck_cleanup);
+                this->scheduleExpiry(record.roomId, slot, restart_cleanup);
+                noRecovered++;
+            }
+            else if (record.op == JournalOp::Cancel)
+            {
+                std::optional<typename IndexType::Data> interval;
+                {
+                    std::lock_guard lock(this->lck_cleanup);
+                    interval = this->unbook(booking);
+                }
+
+                if (interval.has_value())
+                    this->removeBooking(interval.value());
+            }
+        }
+    }
+
+    if (restart_cleanup)
+        this->restartCleanup();
+
+    return noRecovered;
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::removeExpiredBookings(const sys_time<milliseconds> &now)
+{
+    std::vector<std::unique_ptr<BookingShard>> pastShards;
+    auto today = dayOf(floor<typename IntervalType::duration>(now));
+
+    // Every booking of a past day either ended or is also stored in the shards of the following days
+    {
+        std::lock_guard guard_write(this->lck_shards);
+
+        while (!this->shards.empty() && this->shards.begin()->first < today)
+        {
+            pastShards.push_back(std::move(this->shards.begin()->second));
+            this->shards.erase(this->shards.begin());
+        }
+    }
+
+    {
+        std::shared_lock guard_shards(this->lck_shards);
+
+        if (auto itShard = this->shards.find(today); itShard != this->shards.end())
+            itShard->second->index.removeEndingBefore(floor<typename IntervalType::duration>(now));
+    }
+
+    // Past shards are freed here, outside of the shard map lock
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::expireBookings(std::unique_lock<std::recursive_mutex> &lock)
+{
+    auto now = this->clock.now();
+    SchedulerMetrics::Timer timer(this->metrics, SchedulerOp::Expiry);
+
+    auto noExpired = this->expiryWheel.advance(now.time_since_epoch().count(), [this](uint32_t id)
+                                               { this->releaseBooking(id); });
+
+    // Expired bookings are dropped with their day or pruned in one tree pass, without blocking the bookings scheduling their own expiry.
+    // Occurrences of recurring bookings have no expiry entry: the days they are on are dropped as the horizon moves on.
+    lock.unlock();
+
+    auto horizonMoved = this->materializeSeries();
+    if (noExpired != 0 || horizonMoved)
+        this->removeExpiredBookings(now);
+
+    lock.lock();
+
+    if (noExpired != 0)
+        timer.stop(1, noExpired);
+
+    auto nextExpiry = this->expiryWheel.nextExpiry();
+    this->cleanupWakeupTime = nextExpiry.has_value() ? sys_time<milliseconds>(milliseconds(nextExpiry.value())) : now + hours(1);
+
+    return noExpired;
+}
+
+template <typename IndexType, typename ClockType>
+size_t BasicMeetingRoomScheduler<IndexType, ClockType>::advanceClock(typename ClockType::time_point time)
+    requires ClockType::IsVirtual
+{
+    std::unique_lock lock(this->lck_cleanup);
+
+    this->clock.advanceTo(time);
+    return this->expireBookings(lock);
+}
+
+template <typename IndexType, typename ClockType>
+void BasicMeetingRoomScheduler<IndexType, ClockType>::run_cleanup()
+{
+    std::unique_lock lock(this->lck_cleanup);
+
+    do
+    {
+        this->expireBookings(lock);
+
+        cv_wakeCleanupThread.wait_until(lock, this->cleanupWakeupTime, [&]
+                                        { return this->stop || this->restart; });
+
+        this->restart = false;
+
+    } while (!this->stop);
+}
+
+template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId>>;
+template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId, PooledNodes, SnapshotReads>>;
+template class BasicMeetingRoomScheduler<FlatIntervalIndex<sys_time<milliseconds>, RoomId>>;
+template class BasicMeetingRoomScheduler<IntervalTree<sys_time<milliseconds>, RoomId>, VirtualClock>;
+template class BasicMeetingRoomScheduler<IntervalTree<MinuteTime, RoomId>>;
+template class BasicMeetingRoomScheduler<FlatIntervalIndex<MinuteTime, RoomId>>;
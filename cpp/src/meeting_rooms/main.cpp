@@ -1,8 +1,34 @@
 #include <iostream>
 #include <vector>
 #include <charconv>
+#include <numeric>
 
 #include "include/meeting_rooms.h"
+#include "driver/load_generator.h"
+#include "driver/booking_trace.h"
+
+// Global heap allocations done by the process, reported per booking request
+std::atomic<size_t> nr_allocations = 0;
+
+void *operator new(size_t size)
+{
+    nr_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto p = std::malloc(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
 
 void generate_indices(int low, int high, std::vector<int> &out)
 {
@@ -16,9 +42,18 @@ void generate_indices(int low, int high, std::vector<int> &out)
     generate_indices(mid + 1, high, out);
 }
 
+void generate_sorted_indices(int low, int high, std::vector<int> &out)
+{
+    for (int i = low; i <= high; i++)
+        out.push_back(i);
+}
+
 int main(int argc, char *argv[])
 {
-    size_t nr_threads = 1, nr_intervals = 5000000, nr_rooms = 3;
+    size_t nr_threads = 1, nr_intervals = 5000000, nr_rooms = 3, meeting_minutes = 1, batch_size = 1;
+    std::string_view insertion_order = "balanced", mode = "sequence", trace_out, trace_in;
+    double replay_speed = 0;
+    WorkloadConfig workload;
 
     if (argc > 1 && (argc - 1) % 2 == 0)
     {
@@ -32,7 +67,21 @@ int main(int argc, char *argv[])
 
             return result;
         };
-        
+
+        auto next_string = [&args](int pos)
+        {
+            return args[pos + 1];
+        };
+
+        auto next_double = [&args](int pos)
+        {
+            auto str = args[pos + 1];
+            auto result = 0.0;
+            std::from_chars(str.data(), str.data() + str.size(), result);
+
+            return result;
+        };
+
         for (auto i = 0; i < argc; i++)
         {
             if (args[i] == "-t")
@@ -49,10 +98,93 @@ int main(int argc, char *argv[])
             {
                 nr_rooms = next_token(i++);
             }
+
+            // Meeting length, longer meetings overlap more bookings (use with thousands of rooms)
+            if (args[i] == "-d")
+            {
+                meeting_minutes = next_token(i++);
+            }
+
+            // Requests sent at once through requestRooms, 1 books every slot with requestRoom
+            if (args[i] == "-b")
+            {
+                batch_size = std::max(next_token(i++), 1);
+            }
+
+            // 'sequence' books the same slots from every thread, 'mixed' runs the load generator
+            if (args[i] == "-m")
+            {
+                mode = next_string(i++);
+            }
+
+            // Weights of the mixed workload operations: book any room, book by name, cancel, query
+            if (args[i] == "-x")
+            {
+                auto mix = next_string(i++);
+                auto pos = mix.data();
+
+                for (auto &weight : workload.op_mix)
+                {
+                    weight = 0;
+                    pos = std::from_chars(pos, mix.data() + mix.size(), weight).ptr;
+
+                    if (pos != mix.data() + mix.size())
+                        pos++;
+                }
+            }
+
+            // Target rate of the mixed workload in operations/sec, 0 runs closed loop
+            if (args[i] == "-q")
+            {
+                workload.target_rate = next_double(i++);
+            }
+
+            // Start times of the mixed workload slots: 'uniform' or 'business' hours
+            if (args[i] == "-s")
+            {
+                workload.slot_distribution = next_string(i++) == "uniform" ? SlotDistribution::Uniform : SlotDistribution::BusinessHours;
+            }
+
+            // Days ahead over which the mixed workload spreads its slots
+            if (args[i] == "-h")
+            {
+                workload.horizon_days = std::max(next_token(i++), 1);
+            }
+
+            // Zipf exponent of the rooms named by the mixed workload, 0 for uniform
+            if (args[i] == "-z")
+            {
+                workload.room_zipf_exponent = next_double(i++);
+            }
+
+            // Trace file the mixed workload records its operations to
+            if (args[i] == "-w")
+            {
+                trace_out = next_string(i++);
+                workload.record_trace = true;
+            }
+
+            // Trace file streamed back by the 'replay' mode
+            if (args[i] == "-f")
+            {
+                trace_in = next_string(i++);
+            }
+
+            // Replay pacing: 1 in recorded time, 10 ten times faster, 0 (default) as fast as possible
+            if (args[i] == "-p")
+            {
+                replay_speed = next_double(i++);
+            }
+
+            // Insertion order of the booked slots: 'balanced' (midpoint order) or 'sorted' (monotonic)
+            if (args[i] == "-o")
+            {
+                insertion_order = next_string(i++);
+            }
         }
     }
 
-    std::cout << "Config: " << nr_threads << " threads | " << nr_rooms << " rooms | " << nr_intervals << " intervals\n";
+    std::cout << "Config: " << nr_threads << " threads | " << nr_rooms << " rooms | " << nr_intervals << " intervals | " << meeting_minutes << " min meetings | " << insertion_order << " order | " << batch_size << " batch\n";
 
     MeetingRoomScheduler scheduler;
 
@@ -62,21 +194,123 @@ int main(int argc, char *argv[])
         scheduler.registerRoom(mr);
     }
 
+    auto print_workload_result = [](const WorkloadResult &result)
+    {
+        auto elapsed_ms = std::max<int64_t>(result.elapsed.count(), 1);
+
+        auto nr_ops = std::accumulate(result.issued.begin(), result.issued.end(), uint64_t(0));
+        std::cout << "Elapsed: " << elapsed_ms << " ms | " << (nr_ops * 1000) / elapsed_ms << " ops/sec\n";
+
+        for (size_t op = 0; op < NoWorkloadOps; op++)
+        {
+            const auto &latency = result.latency[op];
+
+            auto to_micros = [&](double fraction)
+            { return duration_cast<duration<double, std::micro>>(latency.percentile(fraction)).count(); };
+
+            std::cout << to_string(static_cast<WorkloadOp>(op)) << ": " << result.issued[op] << " issued | " << result.succeeded[op] << " succeeded | "
+                      << (result.issued[op] * 1000) / elapsed_ms << " ops/sec | p50 " << to_micros(0.5) << " us | p99 " << to_micros(0.99)
+                      << " us | p999 " << to_micros(0.999) << " us\n";
+        }
+    };
+
+    if (mode == "mixed")
+    {
+        std::vector<std::string> room_names;
+        for (size_t i = 0; i < nr_rooms; i++)
+            room_names.push_back("#M" + std::to_string(i));
+
+        workload.nr_threads = nr_threads;
+        workload.nr_ops = nr_intervals;
+        workload.meeting_minutes = meeting_minutes;
+
+        std::cout << "Mixed workload: " << workload.op_mix[0] << "/" << workload.op_mix[1] << "/" << workload.op_mix[2] << "/" << workload.op_mix[3]
+                  << " mix | " << workload.target_rate << " ops/sec target | " << workload.horizon_days << " days | zipf " << workload.room_zipf_exponent << "\n";
+
+        auto result = run_workload(scheduler, room_names, workload);
+        print_workload_result(result);
+
+        if (workload.record_trace)
+        {
+            write_trace(std::string(trace_out), static_cast<uint32_t>(nr_rooms), result.base_time_ms, std::move(result.trace));
+            std::cout << "Trace: " << trace_out << "\n";
+        }
+
+        return 0;
+    }
+
+    if (mode == "replay")
+    {
+        try
+        {
+            MappedTrace trace{std::string(trace_in)};
+
+            // The rooms of the trace are registered on top of the -r ones
+            std::vector<std::string> room_names;
+            for (size_t i = 0; i < std::max<size_t>(nr_rooms, trace.getHeader().nr_rooms); i++)
+            {
+                room_names.push_back("#M" + std::to_string(i));
+                scheduler.registerRoom(MeetingRoom{room_names.back(), i});
+            }
+
+            std::cout << "Replay: " << trace.getRecords().size() << " operations | ";
+            if (replay_speed > 0)
+                std::cout << replay_speed << "x recorded speed\n";
+            else
+                std::cout << "max speed\n";
+            print_workload_result(replay_trace(scheduler, room_names, trace, nr_threads, replay_speed));
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << e.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
     std::vector<int> indices;
-    generate_indices(1, nr_intervals, indices);
+    if (insertion_order == "sorted")
+        generate_sorted_indices(1, nr_intervals, indices);
+    else
+        generate_indices(1, nr_intervals, indices);
 
-    auto requestRoom = [&scheduler, &indices]()
+    std::atomic<size_t> nr_bookings = 0;
+
+    auto requestRoom = [&scheduler, &indices, &nr_bookings, meeting_minutes, batch_size]()
     {
         auto now = system_clock::now();
+        std::vector<DateTimeSlot> batch;
 
         for (size_t i = 0; i < indices.size(); i++)
         {
-            auto rnd_ts = DateTimeSlot((now + seconds(indices[i])), 1);
+            auto rnd_ts = DateTimeSlot((now + seconds(indices[i])), meeting_minutes);
+
+            if (batch_size == 1)
+            {
+                if (scheduler.requestRoom(rnd_ts).has_value())
+                    nr_bookings.fetch_add(1, std::memory_order_relaxed);
 
-            auto room = scheduler.requestRoom(rnd_ts);
+                continue;
+            }
+
+            batch.push_back(rnd_ts);
+            if (batch.size() < batch_size && i + 1 < indices.size())
+                continue;
+
+            for (const auto &booking : scheduler.requestRooms(batch))
+            {
+                if (booking.has_value())
+                    nr_bookings.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            batch.clear();
         }
     };
 
+    auto start = steady_clock::now();
+    auto allocations_before = nr_allocations.load();
+
     std::vector<std::thread> threads;
     for (size_t tn = 0; tn < nr_threads; tn++)
     {
@@ -88,5 +322,28 @@ int main(int argc, char *argv[])
         thread.join();
     }
 
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+    auto nr_requests = nr_threads * indices.size();
+    std::cout << "Bookings: " << nr_bookings << " of " << nr_requests << " requests\n";
+    std::cout << "Allocations: " << static_cast<double>(nr_allocations.load() - allocations_before) / nr_requests << " per request\n";
+    std::cout << "Elapsed: " << elapsed.count() << " ms | " << (nr_requests * 1000) / std::max<int64_t>(elapsed.count(), 1) << " requests/sec\n";
+
+    auto stats = scheduler.stats();
+    const std::pair<SchedulerOp, std::string_view> ops[] = {{SchedulerOp::Book, "book"}, {SchedulerOp::Query, "query"}, {SchedulerOp::Cancel, "cancel"}, {SchedulerOp::Expiry, "expiry"}, {SchedulerOp::BookBatch, "book batch"}};
+
+    for (auto [op, name] : ops)
+    {
+        const auto &opStats = stats[op];
+        if (opStats.calls == 0)
+            continue;
+
+        auto toMicros = [&](double fraction)
+        { return duration_cast<duration<double, std::micro>>(opStats.latency.percentile(fraction)).count(); };
+
+        std::cout << name << ": " << opStats.calls << " calls | " << opStats.succeeded << " succeeded | "
+                  << (opStats.calls * 1000) / std::max<int64_t>(elapsed.count(), 1) << " ops/sec | p50 " << toMicros(0.5)
+                  << " us | p99 " << toMicros(0.99) << " us | p999 " << toMicros(0.999) << " us\n";
+    }
+
     return 0;
 }
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <thread>
+#include <vector>
+#include <tuple>
+
+#include "../include/booking_journal.h"
+
+namespace
+{
+    // Empty scratch directory of a test, removed with its files at the end of the test
+    struct ScratchDirectory
+    {
+        std::filesystem::path path;
+
+        explicit ScratchDirectory(const std::string &name) : path(std::filesystem::temp_directory_path() / ("meeting_rooms_" + name))
+        {
+            std::filesystem::remove_all(this->path);
+            std::filesystem::create_directories(this->path);
+        }
+
+        ~ScratchDirectory() { std::filesystem::remove_all(this->path); }
+
+        std::string file(const std::string &name) const { return (this->path / name).string(); }
+    };
+
+    std::vector<std::tuple<RoomId, int64_t, int64_t>> sortedBookings(SimulatedMeetingRoomScheduler &scheduler)
+    {
+        std::vector<std::tuple<RoomId, int64_t, int64_t>> bookings;
+        for (const auto &booking : scheduler.exportBookings())
+            bookings.emplace_back(booking.roomId, booking.timeSlot.getStartTime().time_since_epoch().count(), booking.timeSlot.getEndTime().time_since_epoch().count());
+
+        std::sort(bookings.begin(), bookings.end());
+        return bookings;
+    }
+}
+
+TEST(booking_journal, recover_snapshot_and_journal)
+{
+    ScratchDirectory dir("recover");
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    {
+        BookingJournal journal(dir.file("bookings.journal"));
+        scheduler.attachJournal(&journal);
+
+        std::vector<MeetingRoomBooking> bookings;
+        for (int i = 0; i < 20; i++)
+            bookings.push_back(scheduler.requestRoom(DateTimeSlot(start + hours(i), 60)).value());
+
+        EXPECT_TRUE(scheduler.cancelBooking(bookings[3]));
+
+        // Spans midnight, stored in two day shards and snapshotted once
+        ASSERT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start + hours(15), 120)).has_value());
+
+        scheduler.writeSnapshot(dir.file("bookings.snapshot"));
+        EXPECT_FALSE(std::filesystem::exists(BookingJournal::retiredPathOf(journal.getPath())));
+
+        // After the snapshot, only in the journal
+        EXPECT_TRUE(scheduler.cancelBooking(bookings[5]));
+        EXPECT_EQ(scheduler.requestRooms(std::vector<DateTimeSlot>{DateTimeSlot(start + hours(30), 30), DateTimeSlot(start + hours(30), 30)}).size(), 2);
+        ASSERT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start + hours(5), 60)).has_value());
+
+        scheduler.attachJournal(nullptr);
+    }
+
+    BookingSnapshot snapshot(dir.file("bookings.snapshot"));
+    ASSERT_EQ(snapshot.getRecords().size(), 20);
+
+    // Plain records of the booked slots, nothing of the in-memory bookings
+    auto spanning = std::find_if(snapshot.getRecords().begin(), snapshot.getRecords().end(), [&](const SnapshotRecord &record)
+                                 { return record.roomId == 1; });
+    ASSERT_NE(spanning, snapshot.getRecords().end());
+    EXPECT_EQ(spanning->reserved, 0);
+    EXPECT_EQ(spanning->startMs, time_point_cast<milliseconds>(start + hours(15)).time_since_epoch().count());
+    EXPECT_EQ(spanning->endMs, time_point_cast<milliseconds>(start + hours(17)).time_since_epoch().count());
+
+    SimulatedMeetingRoomScheduler recovered{VirtualClock(start)};
+    recovered.registerRoom({"M1", 4});
+    recovered.registerRoom({"M2", 8});
+
+    {
+        // Replayed records are not journaled again
+        BookingJournal journal(dir.file("recovered.journal"));
+        recovered.attachJournal(&journal);
+
+        EXPECT_EQ(recovered.recover(dir.file("bookings.snapshot"), dir.file("bookings.journal")), 20 + 3);
+        recovered.attachJournal(nullptr);
+    }
+
+    EXPECT_TRUE(BookingJournal::recordsOf(MappedFile(dir.file("recovered.journal"))).empty());
+    EXPECT_EQ(sortedBookings(recovered), sortedBookings(scheduler));
+
+    // Recovered bookings, from the snapshot or the journal, are cancelled through their handles
+    EXPECT_FALSE(recovered.findBooking(0, DateTimeSlot(start + hours(5), 60)).has_value());
+
+    auto fromSnapshot = recovered.findBooking(0, DateTimeSlot(start + hours(7), 60));
+    auto fromJournal = recovered.findBooking(1, DateTimeSlot(start + hours(5), 60));
+    ASSERT_TRUE(fromSnapshot.has_value() && fromJournal.has_value());
+
+    EXPECT_TRUE(recovered.cancelBooking(fromSnapshot->handle));
+    EXPECT_TRUE(recovered.cancelBooking(fromJournal->handle));
+    EXPECT_FALSE(recovered.cancelBooking(fromJournal->handle));
+    EXPECT_TRUE(recovered.isRoomAvailable("M2", DateTimeSlot(start + hours(5), 60)));
+
+    // Recovered bookings expire as the others
+    EXPECT_EQ(recovered.advanceClock(start + hours(2)), 2);
+}
+
+TEST(booking_journal, interrupted_snapshot)
+{
+    ScratchDirectory dir("interrupted");
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    scheduler.registerRoom({"M1", 4});
+
+    {
+        BookingJournal journal(dir.file("bookings.journal"));
+        scheduler.attachJournal(&journal);
+
+        ASSERT_TRUE(scheduler.requestRoom(DateTimeSlot(start, 60)).has_value());
+
+        // As if the snapshot after the rotation never completed, the next rotation keeps the retired records
+        journal.rotate();
+        ASSERT_TRUE(scheduler.requestRoom(DateTimeSlot(start + hours(1), 60)).has_value());
+        journal.rotate();
+
+        ASSERT_TRUE(scheduler.requestRoom(DateTimeSlot(start + hours(2), 60)).has_value());
+        scheduler.attachJournal(nullptr);
+    }
+
+    SimulatedMeetingRoomScheduler recovered{VirtualClock(start)};
+    recovered.registerRoom({"M1", 4});
+
+    EXPECT_EQ(recovered.recover(dir.file("missing.snapshot"), dir.file("bookings.journal")), 3);
+    EXPECT_EQ(sortedBookings(recovered), sortedBookings(scheduler));
+}
+
+TEST(booking_journal, group_commit)
+{
+    ScratchDirectory dir("group_commit");
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    for (size_t i = 0; i < 8; i++)
+        scheduler.registerRoom({"#M" + std::to_string(i), i});
+
+    {
+        BookingJournal journal(dir.file("bookings.journal"));
+        scheduler.attachJournal(&journal);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; t++)
+        {
+            threads.emplace_back([&, t]
+                                 {
+                                     for (int i = 0; i < 50; i++)
+                                         EXPECT_TRUE(scheduler.requestRoom("#M" + std::to_string(t), DateTimeSlot(start + hours(i), 60)).has_value()); });
+        }
+
+        for (auto &thread : threads)
+            thread.join();
+
+        scheduler.attachJournal(nullptr);
+    }
+
+    MappedFile file(dir.file("bookings.journal"));
+    EXPECT_EQ(BookingJournal::recordsOf(file).size(), 8 * 50);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include "../include/dynamic_bitset.hpp"
+
+TEST(dynamic_bitset, findFirstZero)
+{
+    DynamicBitset bits;
+    bits.reset(1000);
+
+    EXPECT_EQ(bits.findFirstZero(), 0);
+
+    for (size_t i = 0; i < 700; i++)
+        bits.set(i);
+
+    EXPECT_TRUE(bits.test(699));
+    EXPECT_FALSE(bits.test(700));
+    EXPECT_EQ(bits.findFirstZero(), 700);
+    EXPECT_EQ(bits.findFirstZero(10), 700);
+    EXPECT_EQ(bits.findFirstZero(850), 850);
+
+    bits.set(850);
+    EXPECT_EQ(bits.findFirstZero(850), 851);
+
+    for (size_t i = 700; i < 1000; i++)
+        bits.set(i);
+
+    EXPECT_EQ(bits.findFirstZero(), DynamicBitset::npos);
+    EXPECT_EQ(bits.findFirstZero(2000), DynamicBitset::npos);
+
+    // Reset clears previously set bits
+    bits.reset(64);
+    EXPECT_EQ(bits.findFirstZero(), 0);
+
+    for (size_t i = 0; i < 64; i++)
+        bits.set(i);
+
+    EXPECT_EQ(bits.findFirstZero(), DynamicBitset::npos);
+}
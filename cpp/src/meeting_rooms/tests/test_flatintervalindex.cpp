@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../include/flat_interval_index.hpp"
+#include "../include/meeting_rooms.h"
+
+TEST(flat_interval_index, overlaps)
+{
+    using IndexType = FlatIntervalIndex<int, int>;
+    auto index = std::make_unique<IndexType>();
+
+    std::vector<IndexType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        index->insert(e);
+
+    EXPECT_EQ(index->getOverlappingIntervalsWith(6, 7).size(), 2);
+    EXPECT_EQ(index->getOverlappingIntervalsWith(0, 20).size(), 7);
+    EXPECT_TRUE(index->anyOverlap(20, 21, 7));
+    EXPECT_FALSE(index->anyOverlap(20, 21, 5));
+
+    EXPECT_TRUE(index->tryInsertIfNoOverlap({1, 2, 8}));
+    EXPECT_FALSE(index->tryInsertIfNoPayloadOverlap({12, 13, 5}));
+
+    index->remove({4, 100, 7});
+    EXPECT_EQ(index->getOverlappingIntervalsWith(6, 7).size(), 1);
+
+    EXPECT_EQ(index->removeEndingBefore(6), 5);
+    EXPECT_EQ(index->getIntervalsEndingBefore(100).size(), 2);
+}
+
+TEST(flat_interval_index, unsigned_keys)
+{
+    using IndexType = FlatIntervalIndex<uint32_t, int>;
+    auto index = std::make_unique<IndexType>();
+
+    // Keys above INT32_MAX keep their order once stored as signed lanes
+    index->insert({0x7fffff00u, 0x80000100u, 1});
+    index->insert({0x90000000u, 0x90000010u, 2});
+
+    EXPECT_EQ(index->getOverlappingIntervalsWith(0x80000000u, 0x80000001u).size(), 1);
+    EXPECT_EQ(index->getOverlappingIntervalsWith(0x10u, 0x20u).size(), 0);
+    EXPECT_EQ(index->getIntervalsEndingBefore(0xffffffffu).size(), 2);
+}
+
+// Exposes the lane masks of a node, to check the vector path of the build against the scalar one
+template <typename IntervalType>
+struct LaneMasks : FlatIntervalIndex<IntervalType, int>
+{
+    using Base = FlatIntervalIndex<IntervalType, int>;
+    using Raw = typename Base::Raw;
+
+    static void expectScalarMasks(uint64_t seed)
+    {
+        constexpr Raw Min = std::numeric_limits<Raw>::min(), Max = std::numeric_limits<Raw>::max();
+
+        std::mt19937_64 gen(seed);
+        std::uniform_int_distribution<Raw> any(Min, Max), offset(-2, 2);
+
+        // Bounds at both ends of the range, where a compare of the wrong signedness or width fails first
+        auto nearTo = [&](Raw value)
+        {
+            auto delta = offset(gen);
+            return (delta > 0 && value > Max - delta) || (delta < 0 && value < Min - delta) ? value : static_cast<Raw>(value + delta);
+        };
+
+        for (int i = 0; i < 10000; i++)
+        {
+            Raw bound = i % 4 == 0 ? nearTo(Min) : i % 4 == 1 ? nearTo(Max) : any(gen);
+
+            Raw values[Base::Fanout];
+            for (auto &value : values)
+                value = gen() % 2 == 0 ? nearTo(bound) : any(gen);
+
+            uint32_t greater = 0;
+            for (uint32_t lane = 0; lane < Base::Fanout; lane++)
+                greater |= static_cast<uint32_t>(values[lane] > bound) << lane;
+
+            ASSERT_EQ(Base::lessThanMask(values, bound), Base::scalarLessThanMask(values, bound));
+            ASSERT_EQ(Base::greaterThanMask(values, bound), greater);
+        }
+    }
+};
+
+TEST(flat_interval_index, vector_masks)
+{
+    LaneMasks<int64_t>::expectScalarMasks(11);
+    LaneMasks<int32_t>::expectScalarMasks(13);
+    LaneMasks<std::chrono::sys_time<std::chrono::milliseconds>>::expectScalarMasks(17);
+}
+
+TEST(flat_interval_index, matches_interval_tree)
+{
+    using IndexType = FlatIntervalIndex<int64_t, int>;
+    auto index = std::make_unique<IndexType>();
+    auto tree = std::make_unique<IntervalTree<int64_t, int>>();
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int64_t> start(0, 100000), length(1, 500);
+    std::uniform_int_distribution<int> payload(0, 9);
+
+    std::vector<IndexType::Data> inserted;
+    for (int i = 0; i < 20000; i++)
+    {
+        auto low = start(gen);
+        IndexType::Data e{low, low + length(gen), payload(gen)};
+
+        EXPECT_EQ(index->tryInsertIfNoPayloadOverlap(e), tree->tryInsertIfNoPayloadOverlap({e.low, e.high, e.payload}));
+        inserted.push_back(e);
+    }
+
+    // Remove every other interval, whether it was booked or not
+    for (size_t i = 0; i < inserted.size(); i += 2)
+    {
+        index->remove(inserted[i]);
+        tree->remove({inserted[i].low, inserted[i].high, inserted[i].payload});
+    }
+
+    index->removeEndingBefore(20000);
+    tree->removeEndingBefore(20000);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        auto low = start(gen), high = low + length(gen);
+
+        size_t indexOverlaps = 0, treeOverlaps = 0;
+        index->forEachOverlapping(low, high, [&](const int64_t &, const int64_t &, const int &)
+                                  { indexOverlaps++; });
+        tree->forEachOverlapping(low, high, [&](const int64_t &, const int64_t &, const int &)
+                                 { treeOverlaps++; });
+
+        EXPECT_EQ(indexOverlaps, treeOverlaps);
+    }
+
+    EXPECT_EQ(index->getIntervalsEndingBefore(200000).size(), tree->getIntervalsEndingBefore(200000).size());
+    EXPECT_LE(index->getHeight(), 5);
+
+    // Gaps of one payload against a scan of its intervals in start order, which do not overlap each other
+    std::vector<std::vector<IndexType::Data>> byPayload(10);
+    index->forEachOverlapping(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), [&](const int64_t &low, const int64_t &high, const int &p)
+                              { byPayload[p].push_back({low, high, p}); });
+
+    for (int i = 0; i < 1000; i++)
+    {
+        auto from = start(gen), gapLength = length(gen);
+        auto p = payload(gen);
+
+        auto expected = from;
+        for (const auto &e : byPayload[p])
+        {
+            if (e.low >= expected + gapLength)
+                break;
+
+            expected = std::max(expected, e.high);
+        }
+
+        EXPECT_EQ(index->findGap(from, gapLength, p), expected);
+        EXPECT_EQ(tree->findGap(from, gapLength, p), expected);
+    }
+}
+
+TEST(flat_interval_index, bulkLoad)
+{
+    using IndexType = FlatIntervalIndex<int, int>;
+    auto index = std::make_unique<IndexType>();
+
+    index->insert({1, 2, 9});
+
+    const int noIntervals = 1 << 12;
+    std::vector<IndexType::Data> intervals;
+    for (int i = 0; i < noIntervals; i++)
+        intervals.push_back({(i * 7919) % noIntervals, (i * 7919) % noIntervals + 10, i % 3});
+
+    // Stored once
+    intervals.push_back({1, 2, 9});
+
+    index->bulkLoad(intervals);
+
+    EXPECT_EQ(index->getHeight(), 4);
+    EXPECT_EQ(index->getOverlappingIntervalsWith(5, 6).size(), 6);
+    EXPECT_EQ(index->getOverlappingIntervalsWith(1, 2).size(), 3);
+
+    index->insert({noIntervals, noIntervals + 1, 1});
+    EXPECT_EQ(index->removeEndingBefore(noIntervals + 10), noIntervals + 2);
+    EXPECT_TRUE(index->isEmpty());
+}
+
+TEST(flat_interval_index, scheduler_backend)
+{
+    BasicMeetingRoomScheduler<FlatIntervalIndex<sys_time<milliseconds>, RoomId>> scheduler;
+
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    auto slot = DateTimeSlot(2023y / 11 / 28, 23u, 30u, 60u);
+
+    auto booking = scheduler.requestRoom(slot);
+    ASSERT_TRUE(booking.has_value());
+    EXPECT_TRUE(scheduler.requestRoom("M2", slot).has_value());
+    EXPECT_FALSE(scheduler.requestRoom(slot).has_value());
+
+    scheduler.cancelBooking(booking.value());
+    EXPECT_TRUE(scheduler.requestRoom(DateTimeSlot(2023y / 11 / 29, 0u, 0u, 15u)).has_value());
+}
@@ -100,4 +100,272 @@ TEST(interval_tree, getIntervalsEndingBefore)
     EXPECT_EQ(tree->getIntervalsEndingBefore(2).size(), 2);
     EXPECT_EQ(tree->getIntervalsEndingBefore(6).size(), 4);
     EXPECT_EQ(tree->getIntervalsEndingBefore(15).size(), 6);
-}
\ No newline at end of file
+}
+
+TEST(interval_tree, balanced_sorted_inserts)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    const int noIntervals = 1 << 16;
+
+    // Monotonic insertion would degrade an unbalanced tree to a list
+    for (int i = 0; i < noIntervals; i++)
+        tree->insert({i, i + 2, i});
+
+    // AVL height bound is ~1.44 * log2(n)
+    EXPECT_LE(tree->getHeight(), 24);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(100, 101).size(), 2);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(noIntervals, noIntervals + 10).size(), 1);
+    EXPECT_EQ(tree->getIntervalsEndingBefore(10).size(), 9);
+
+    for (int i = 0; i < noIntervals; i += 2)
+        tree->remove({i, i + 2, i});
+
+    EXPECT_LE(tree->getHeight(), 23);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(100, 101).size(), 1);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, noIntervals + 2).size(), noIntervals / 2);
+
+    for (int i = 1; i < noIntervals; i += 2)
+        tree->remove({i, i + 2, i});
+
+    EXPECT_TRUE(tree->isEmpty());
+}
+
+TEST(interval_tree, remove_same_low)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    // Intervals starting at the same point but ending at different points are distinct nodes
+    std::vector<IntervalTreeType::Data> intervals{{5, 10, 1}, {5, 6, 2}, {5, 50, 3}, {1, 4, 4}, {7, 8, 5}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(20, 30).size(), 1);
+
+    tree->remove(intervals[2]);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(20, 30).size(), 0);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(5, 6).size(), 2);
+
+    tree->remove(intervals[0]);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(5, 6).size(), 1);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, 100).size(), 3);
+}
+
+TEST(interval_tree, heap_nodes)
+{
+    using IntervalTreeType = IntervalTree<int, int, HeapNodes>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    std::vector<IntervalTreeType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(1, 100).size(), 5);
+
+    for (auto e : intervals)
+        tree->remove(e);
+
+    EXPECT_TRUE(tree->isEmpty());
+
+    // Reinserting after the tree emptied allocates fresh nodes
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(2, 7).size(), 4);
+}
+
+TEST(interval_tree, forEachOverlapping)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    std::vector<IntervalTreeType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    std::vector<int> lows;
+    EXPECT_TRUE(tree->forEachOverlapping(2, 7, [&](int low, int, int)
+                                         { lows.push_back(low); }));
+
+    // Visited in ascending order
+    EXPECT_EQ(lows, (std::vector<int>{2, 3, 4, 5}));
+
+    int visited = 0;
+    EXPECT_FALSE(tree->forEachOverlapping(1, 100, [&](int, int, int)
+                                          { return ++visited < 2; }));
+    EXPECT_EQ(visited, 2);
+
+    visited = 0;
+    EXPECT_TRUE(tree->forEachEndingBefore(6, [&](int, int high, int)
+                                          { visited++; return high <= 6; }));
+    EXPECT_EQ(visited, 4);
+}
+
+TEST(interval_tree, anyOverlap)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    std::vector<IntervalTreeType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_TRUE(tree->anyOverlap(0, 1));
+    EXPECT_FALSE(tree->anyOverlap(1, 2));
+    EXPECT_TRUE(tree->anyOverlap(0, 1, 2));
+    EXPECT_FALSE(tree->anyOverlap(0, 1, 3));
+    EXPECT_TRUE(tree->anyOverlap(50, 60, 7));
+    EXPECT_FALSE(tree->anyOverlap(7, 10, 3));
+    EXPECT_TRUE(tree->anyOverlap(14, 12, 5));
+}
+
+TEST(interval_tree, tryInsertIfNoOverlap)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    EXPECT_TRUE(tree->tryInsertIfNoOverlap({0, 10, 1}));
+    EXPECT_FALSE(tree->tryInsertIfNoOverlap({5, 15, 2}));
+    EXPECT_TRUE(tree->tryInsertIfNoOverlap({10, 15, 2}));
+
+    EXPECT_FALSE(tree->tryInsertIfNoPayloadOverlap({5, 15, 1}));
+    EXPECT_TRUE(tree->tryInsertIfNoPayloadOverlap({5, 15, 3}));
+
+    auto payload = tree->tryInsertSelected(
+        0, 20, [](int, int, int) {}, []() -> std::optional<int>
+        { return 4; });
+    EXPECT_EQ(payload, 4);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, 20).size(), 4);
+}
+
+TEST(interval_tree, removeEndingBefore)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    std::vector<IntervalTreeType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_EQ(tree->removeEndingBefore(6), 4);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, 100).size(), 3);
+    EXPECT_EQ(tree->getIntervalsEndingBefore(6).size(), 0);
+    EXPECT_EQ(tree->removeEndingBefore(6), 0);
+
+    EXPECT_EQ(tree->removeEndingBefore(1000), 3);
+    EXPECT_TRUE(tree->isEmpty());
+}
+
+TEST(interval_tree, removeIf_keeps_balance)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    const int noIntervals = 1 << 15;
+    for (int i = 0; i < noIntervals; i++)
+        tree->insert({i, i + 10, i % 3});
+
+    // Removing a whole prefix at once leaves a tree that still needs to be balanced
+    EXPECT_EQ(tree->removeEndingBefore(noIntervals / 2 + 10), noIntervals / 2 + 1);
+    EXPECT_LE(tree->getHeight(), 22);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, noIntervals / 2 + 10).size(), 9);
+
+    EXPECT_EQ(tree->removeIf([](int, int, int payload)
+                             { return payload == 0; }),
+              (noIntervals - 1) / 3 - (noIntervals / 2) / 3);
+    EXPECT_LE(tree->getHeight(), 22);
+    EXPECT_FALSE(tree->anyOverlap(0, noIntervals + 10, 0));
+    EXPECT_TRUE(tree->anyOverlap(noIntervals, noIntervals + 10, 1));
+
+    // maxHigh is fixed up by the pruning: the longest interval is still found from the far end
+    tree->insert({0, noIntervals * 2, 5});
+    EXPECT_GT(tree->removeIf([](int low, int, int)
+                             { return low > 0 && low % 2 == 0; }),
+              0);
+    EXPECT_TRUE(tree->anyOverlap(noIntervals + 100, noIntervals + 101, 5));
+
+    std::vector<IntervalTreeType::Data> remaining{{0, noIntervals * 2, 5}};
+    tree->removeAll(remaining);
+    EXPECT_FALSE(tree->anyOverlap(noIntervals + 100, noIntervals + 101));
+}
+
+TEST(interval_tree, snapshot_reads)
+{
+    using IntervalTreeType = IntervalTree<int, int, PooledNodes, SnapshotReads>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    std::vector<IntervalTreeType::Data> intervals{{0, 1, 1}, {0, 1, 2}, {3, 7, 3}, {2, 6, 4}, {10, 15, 5}, {5, 6, 6}, {4, 100, 7}};
+    for (auto e : intervals)
+        tree->insert(e);
+
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(2, 7).size(), 4);
+    EXPECT_EQ(tree->removeEndingBefore(6), 4);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(0, 100).size(), 3);
+
+    const int noIntervals = 5000;
+    std::atomic_bool writerDone = false;
+
+    // Readers run without locks while the writer inserts and prunes
+    auto reader = [&]()
+    {
+        while (!writerDone)
+        {
+            int previousLow = -1;
+            bool ordered = true;
+
+            tree->forEachOverlapping(0, noIntervals * 2, [&](int low, int, int)
+                                     { ordered = ordered && previousLow <= low; previousLow = low; });
+
+            EXPECT_TRUE(ordered);
+            EXPECT_TRUE(tree->anyOverlap(10, 15, 5));
+        }
+    };
+
+    std::thread reader1(reader), reader2(reader);
+
+    for (int i = 20; i < noIntervals; i++)
+    {
+        tree->insert({i, i + 5, i});
+
+        if (i % 100 == 0)
+            tree->removeIf([i](int low, int, int)
+                           { return low >= 20 && low < i - 50; });
+    }
+
+    writerDone = true;
+    reader1.join();
+    reader2.join();
+
+    // Intervals starting after the last prune, plus {4, 100}
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(20, noIntervals * 2).size(), 151);
+    EXPECT_LE(tree->getHeight(), 10);
+}
+
+TEST(interval_tree, bulkLoad)
+{
+    using IntervalTreeType = IntervalTree<int, int>;
+    auto tree = std::make_unique<IntervalTreeType>();
+
+    tree->insert({1, 2, 9});
+
+    const int noIntervals = 1 << 16;
+    std::vector<IntervalTreeType::Data> intervals;
+    for (int i = 0; i < noIntervals; i++)
+        intervals.push_back({(i * 7919) % noIntervals, (i * 7919) % noIntervals + 10, i % 3});
+
+    // Shares the node of {5, 15, 2}
+    intervals.push_back({5, 15, 7});
+
+    tree->bulkLoad(intervals, true);
+
+    EXPECT_EQ(tree->getHeight(), 17);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(5, 6).size(), 7);
+    EXPECT_EQ(tree->getOverlappingIntervalsWith(1, 2).size(), 3);
+    EXPECT_TRUE(tree->anyOverlap(noIntervals + 5, noIntervals + 6));
+    EXPECT_EQ(tree->removeEndingBefore(noIntervals + 10), noIntervals + 2);
+    EXPECT_TRUE(tree->isEmpty());
+}
@@ -27,13 +27,54 @@ TEST(meeting_rooms, timeSlot_ctor)
     EXPECT_TRUE(ts == ts2);
 }
 
+TEST(meeting_rooms, timeSlot_toChars)
+{
+    DateTimeSlot ts(2023y / 11 / 28, 23u, 15u, 60u);
+    EXPECT_EQ(ts.toString(), "2023-11-28 23:15 - 2023-11-29 00:15");
+
+    char buffer[20];
+    auto result = ts.toChars(buffer, buffer + sizeof(buffer));
+    EXPECT_EQ(result.ec, std::errc::value_too_large);
+}
+
+TEST(meeting_rooms, compact_keys)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    CompactMeetingRoomScheduler scheduler;
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    static_assert(sizeof(MinuteTime) == 4);
+
+    auto booking = scheduler.requestRoom(DateTimeSlot(start, 60));
+    ASSERT_TRUE(booking.has_value());
+    EXPECT_TRUE(scheduler.requestRoom(DateTimeSlot(start + minutes(30), 60)).has_value());
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(start + minutes(45), 15)).has_value());
+
+    // Keys are rounded down to whole minutes, the slot of a booking stays as requested
+    auto late = scheduler.requestRoom("M1", DateTimeSlot(start + minutes(60) + seconds(30), 30));
+    ASSERT_TRUE(late.has_value());
+    EXPECT_EQ(late->timeSlot.getStartTime(), start + minutes(60) + seconds(30));
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", DateTimeSlot(start + minutes(60), 1)));
+
+    auto slot = scheduler.findNextFreeSlot("M1", start, 30);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot->getStartTime(), start + minutes(90));
+
+    EXPECT_TRUE(scheduler.cancelBooking(booking.value()));
+    EXPECT_TRUE(scheduler.isRoomAvailable("M1", DateTimeSlot(start, 60)));
+
+    EXPECT_EQ(scheduler.exportBookings().size(), 2);
+}
+
 TEST(meeting_rooms, MeetingRoom_book)
 {
     MeetingRoom m1("M1", 4);
 
     auto slot1 = DateTimeSlot(2023y / 11 / 28, 15u, 30u, 60u);
 
-    MeetingRoomScheduler scheduler;
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(sys_days(2023y / 11 / 28))};
 
     auto booking = scheduler.requestRoom(slot1);
     EXPECT_FALSE(booking.has_value());
@@ -61,7 +102,7 @@ TEST(meeting_rooms, MeetingRoom_book_2)
 
     auto slot1 = DateTimeSlot(2023y / 11 / 28, 15u, 30u, 60u);
 
-    MeetingRoomScheduler scheduler;
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(sys_days(2023y / 11 / 28))};
     scheduler.registerRoom(m1);
     scheduler.registerRoom(m2);
 
@@ -82,7 +123,7 @@ TEST(meeting_rooms, MeetingRoom_book_with_room_name)
 
     auto slot1 = DateTimeSlot(2023y / 11 / 28, 15u, 30u, 60u);
 
-    MeetingRoomScheduler scheduler;
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(sys_days(2023y / 11 / 28))};
     scheduler.registerRoom(m1);
 
     auto room = scheduler.requestRoom(slot1);
@@ -139,7 +180,7 @@ TEST(meeting_rooms, remove_passed_bookings)
 
             if (room.has_value())
             {
-                // std::cout << "Room " << room->meetingRoom.getName() << "\n" << room->timeSlot.toString();
+                // std::cout << "Room " << scheduler.getRoom(room->roomId).getName() << "\n" << room->timeSlot.toString();
             }
             else
             {
@@ -155,4 +196,461 @@ TEST(meeting_rooms, remove_passed_bookings)
     t1.join();
     t2.join();
     t3.join();
-}
\ No newline at end of file
+}
+
+TEST(meeting_rooms, expire_on_virtual_time)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    scheduler.registerRoom({"M1", 4});
+
+    // A booking every hour for two weeks
+    for (int i = 0; i < 14 * 24; i++)
+        ASSERT_TRUE(scheduler.requestRoom(DateTimeSlot(start + hours(i), 60)).has_value());
+
+    EXPECT_EQ(scheduler.advanceClock(start + minutes(59)), 0);
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", DateTimeSlot(start, 60)));
+
+    EXPECT_EQ(scheduler.advanceClock(start + hours(1)), 1);
+    EXPECT_TRUE(scheduler.isRoomAvailable("M1", DateTimeSlot(start, 60)));
+
+    // Time does not go back
+    EXPECT_EQ(scheduler.advanceClock(start), 0);
+    EXPECT_EQ(scheduler.now(), start + hours(1));
+
+    EXPECT_EQ(scheduler.advanceClock(start + days(7)), 7 * 24 - 1);
+    EXPECT_TRUE(scheduler.isRoomAvailable("M1", DateTimeSlot(start + days(6), 60)));
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", DateTimeSlot(start + days(7), 60)));
+
+    EXPECT_EQ(scheduler.advanceClock(start + days(30)), 7 * 24);
+    EXPECT_EQ(scheduler.stats()[SchedulerOp::Expiry].succeeded, 14 * 24);
+}
+
+TEST(meeting_rooms, cancel_by_handle)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    scheduler.registerRoom({"M1", 4});
+
+    auto slot = DateTimeSlot(start + hours(1), 60);
+
+    auto booking = scheduler.requestRoom(slot);
+    ASSERT_TRUE(booking.has_value());
+    ASSERT_TRUE(booking->handle.isValid());
+
+    EXPECT_TRUE(scheduler.cancelBooking(booking->handle));
+    EXPECT_FALSE(scheduler.cancelBooking(booking->handle));
+    EXPECT_TRUE(scheduler.isRoomAvailable("M1", slot));
+
+    // The id is reused under a new generation, the stale handle leaves the new booking alone
+    auto rebooking = scheduler.requestRoom(slot);
+    ASSERT_TRUE(rebooking.has_value());
+    EXPECT_EQ(rebooking->handle.id, booking->handle.id);
+    EXPECT_NE(rebooking->handle.generation, booking->handle.generation);
+
+    EXPECT_FALSE(scheduler.cancelBooking(booking.value()));
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", slot));
+    EXPECT_FALSE(scheduler.cancelBooking(BookingHandle{42, 1}));
+
+    // Cancelling without a handle releases the handle too
+    EXPECT_TRUE(scheduler.cancelBooking(MeetingRoomBooking{rebooking->roomId, slot}));
+    EXPECT_FALSE(scheduler.cancelBooking(MeetingRoomBooking{rebooking->roomId, slot}));
+
+    auto third = scheduler.requestRoom(slot);
+    ASSERT_TRUE(third.has_value());
+    EXPECT_FALSE(scheduler.cancelBooking(rebooking->handle));
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", slot));
+
+    // Cancelled bookings do not expire, expired ones cannot be cancelled
+    EXPECT_EQ(scheduler.advanceClock(start + hours(3)), 1);
+    EXPECT_FALSE(scheduler.cancelBooking(third.value()));
+}
+
+TEST(meeting_rooms, findNextFreeSlot)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    EXPECT_FALSE(scheduler.findNextFreeSlot(start, 30).has_value());
+
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+    EXPECT_FALSE(scheduler.findNextFreeSlot("M3", start, 30).has_value());
+
+    // M1 busy 9:00-10:00, 10:15-11:00 and 11:30 to 9:00 the next day, M2 busy 9:00-12:00
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(start + hours(1), 60)).has_value());
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(start + hours(2) + minutes(15), 45)).has_value());
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(start + hours(3) + minutes(30), 21 * 60 + 30)).has_value());
+    ASSERT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start + hours(1), 180)).has_value());
+
+    auto slot = scheduler.findNextFreeSlot("M1", start + hours(1), 15);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot->getStartTime(), start + hours(2));
+
+    slot = scheduler.findNextFreeSlot("M1", start + hours(1), 30);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot->getStartTime(), start + hours(3));
+
+    // The gap after the booking spanning midnight
+    slot = scheduler.findNextFreeSlot("M1", start + hours(1), 60);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot->getStartTime(), start + hours(25));
+    EXPECT_TRUE(scheduler.requestRoom("M1", slot.value()).has_value());
+
+    // Free right away
+    slot = scheduler.findNextFreeSlot("M2", start, 60);
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot->getStartTime(), start);
+
+    auto freeSlot = scheduler.findNextFreeSlot(start + hours(1), 30);
+    ASSERT_TRUE(freeSlot.has_value());
+    EXPECT_EQ(freeSlot->roomId, 0);
+    EXPECT_EQ(freeSlot->timeSlot.getStartTime(), start + hours(3));
+
+    freeSlot = scheduler.findNextFreeSlot(start + hours(1), 90);
+    ASSERT_TRUE(freeSlot.has_value());
+    EXPECT_EQ(freeSlot->roomId, 1);
+    EXPECT_EQ(freeSlot->timeSlot.getStartTime(), start + hours(4));
+
+    // Cancelled and expired bookings leave the room's gaps
+    EXPECT_TRUE(scheduler.cancelBooking(MeetingRoomBooking{0, DateTimeSlot(start + hours(2) + minutes(15), 45)}));
+    EXPECT_EQ(scheduler.findNextFreeSlot("M1", start + hours(1), 60)->getStartTime(), start + hours(2));
+
+    scheduler.advanceClock(start + hours(2));
+    EXPECT_EQ(scheduler.findNextFreeSlot("M1", start + hours(1), 60)->getStartTime(), start + hours(1));
+
+    // Staggered bookings: moving the first room's candidate on does not skip the other rooms' earlier bookings
+    auto day = sys_days(2030y / 1 / 7) + hours(10);
+
+    SimulatedMeetingRoomScheduler staggered{VirtualClock(day - hours(1))};
+    staggered.registerRoom({"A", 4});
+    staggered.registerRoom({"B", 4});
+
+    ASSERT_TRUE(staggered.requestRoom("B", DateTimeSlot(day, 10)).has_value());
+    ASSERT_TRUE(staggered.requestRoom("B", DateTimeSlot(day + minutes(30), 10)).has_value());
+    ASSERT_TRUE(staggered.requestRoom("A", DateTimeSlot(day, 60)).has_value());
+
+    freeSlot = staggered.findNextFreeSlot(day, 30);
+    ASSERT_TRUE(freeSlot.has_value());
+    EXPECT_EQ(freeSlot->roomId, 1);
+    EXPECT_EQ(freeSlot->timeSlot.getStartTime(), day + minutes(40));
+    EXPECT_TRUE(staggered.requestRoom("B", freeSlot->timeSlot).has_value());
+}
+
+TEST(meeting_rooms, best_fit_by_seats)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start)};
+    scheduler.registerRoom({"S2", 2});
+    scheduler.registerRoom({"L10", 10});
+    scheduler.registerRoom({"M4", 4});
+    scheduler.registerRoom({"M4b", 4});
+
+    auto slot = DateTimeSlot(start, 60);
+    std::vector<RoomId> bookedRooms;
+
+    for (int i = 0; i < 3; i++)
+    {
+        auto booking = scheduler.requestRoom(slot, 3);
+        ASSERT_TRUE(booking.has_value());
+        bookedRooms.push_back(booking->roomId);
+    }
+
+    EXPECT_EQ(bookedRooms, (std::vector<RoomId>{2, 3, 1}));
+    EXPECT_FALSE(scheduler.requestRoom(slot, 3).has_value());
+    EXPECT_EQ(scheduler.requestRoom(slot, 1)->roomId, 0);
+
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(start + hours(2), 60), 11).has_value());
+
+    // Spanning midnight
+    auto overnight = scheduler.requestRoom(DateTimeSlot(start + hours(15), 120), 5);
+    ASSERT_TRUE(overnight.has_value());
+    EXPECT_EQ(overnight->roomId, 1);
+}
+
+TEST(meeting_rooms, recurring_booking)
+{
+    auto start = sys_days(2024y / 1 / 8) + hours(9);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start - hours(1))};
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    EXPECT_FALSE(scheduler.requestRecurringRoom("M2", RecurrenceRule{DateTimeSlot(start, 15), minutes(10), 3}).has_value());
+
+    auto standup = scheduler.requestRecurringRoom("M2", RecurrenceRule::until(DateTimeSlot(start, 15), weeks(1), start + weeks(51)));
+    ASSERT_TRUE(standup.has_value());
+    EXPECT_EQ(standup->rule.count, 52);
+
+    // Only the occurrences within the horizon are in the index
+    EXPECT_EQ(scheduler.exportBookings().size(), 5);
+    EXPECT_EQ(scheduler.advanceClock(start + weeks(2)), 0);
+    EXPECT_EQ(scheduler.exportBookings().size(), 5);
+
+    // Later occurrences still hold the room, against single bookings and other series
+    EXPECT_FALSE(scheduler.requestRecurringRoom("M2", RecurrenceRule{DateTimeSlot(start + weeks(30) + minutes(10), 30), days(1), 10}).has_value());
+    auto daily = scheduler.requestRecurringRoom(RecurrenceRule{DateTimeSlot(start + weeks(30) + minutes(10), 30), days(1), 10});
+    ASSERT_TRUE(daily.has_value());
+    EXPECT_EQ(daily->roomId, 0);
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(start + weeks(31), 30)).has_value());
+
+    // Conflicts with a single booking beyond the horizon
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(start + weeks(35) + hours(2), 30)).has_value());
+    EXPECT_FALSE(scheduler.requestRecurringRoom("M1", RecurrenceRule{DateTimeSlot(start + weeks(3) + hours(2), 15), weeks(1), 40}).has_value());
+
+    EXPECT_FALSE(scheduler.isRoomAvailable("M2", DateTimeSlot(start + weeks(40), 60)));
+    EXPECT_FALSE(scheduler.requestRoom("M2", DateTimeSlot(start + weeks(45) + minutes(10), 30)).has_value());
+    EXPECT_EQ(scheduler.findNextFreeSlot("M2", start + weeks(48), 30)->getStartTime(), start + weeks(48) + minutes(15));
+
+    auto freeSlot = scheduler.findNextFreeSlot(start + weeks(30) + minutes(10), 30);
+    ASSERT_TRUE(freeSlot.has_value());
+    EXPECT_EQ(freeSlot->roomId, 1);
+    EXPECT_EQ(freeSlot->timeSlot.getStartTime(), start + weeks(30) + minutes(15));
+
+    std::vector<uint64_t> grid(2);
+    EXPECT_EQ(scheduler.availabilityGrid(start + weeks(40), start + weeks(40) + hours(1), minutes(15), grid), 2);
+    EXPECT_EQ(grid[0], 0);
+    EXPECT_EQ(grid[1], 0b1);
+
+    // Requests beyond the horizon were answered from the rules, without inserting the occurrences
+    EXPECT_EQ(scheduler.exportBookings().size(), 6);
+
+    EXPECT_TRUE(scheduler.cancelOccurrence(standup->handle, 3));
+    EXPECT_FALSE(scheduler.cancelOccurrence(standup->handle, 3));
+    EXPECT_TRUE(scheduler.cancelOccurrence(standup->handle, 50));
+    EXPECT_FALSE(scheduler.cancelOccurrence(standup->handle, 52));
+    EXPECT_TRUE(scheduler.isRoomAvailable("M2", DateTimeSlot(start + weeks(3), 15)));
+    EXPECT_TRUE(scheduler.isRoomAvailable("M2", DateTimeSlot(start + weeks(50), 15)));
+    EXPECT_FALSE(scheduler.isRoomAvailable("M2", DateTimeSlot(start + weeks(4), 15)));
+
+    EXPECT_TRUE(scheduler.cancelSeries(standup->handle));
+    EXPECT_FALSE(scheduler.cancelSeries(standup->handle));
+    EXPECT_TRUE(scheduler.isRoomAvailable("M2", DateTimeSlot(start + weeks(4), 15)));
+    EXPECT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start + weeks(51), 15)).has_value());
+}
+
+TEST(meeting_rooms, availabilityGrid)
+{
+    auto start = sys_days(2024y / 3 / 4) + hours(8);
+
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(start - hours(1))};
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(start + minutes(15), 30)).has_value());
+    ASSERT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start - minutes(30), 40)).has_value());
+    ASSERT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(start + minutes(170), 70)).has_value());
+
+    // Twelve blocks of 15 minutes
+    ASSERT_EQ(SimulatedMeetingRoomScheduler::gridRowWords(start, start + hours(3), minutes(15)), 1);
+
+    std::vector<uint64_t> grid(2);
+    EXPECT_EQ(scheduler.availabilityGrid(start, start + hours(3), minutes(15), grid), 2);
+    EXPECT_EQ(grid[0], 0b110);
+    EXPECT_EQ(grid[1], 0b1 | (uint64_t(1) << 11));
+
+    EXPECT_EQ(scheduler.availabilityGrid(start, start + hours(3), minutes(15), std::span(grid).first(1)), 0);
+
+    // Split in word-aligned ranges over ten days, with bookings spanning midnight
+    for (int i = 0; i < 10 * 24; i += 5)
+        ASSERT_TRUE(scheduler.requestRoom(DateTimeSlot(start + hours(i + 1) + minutes(7 * i % 60), 20 + i % 200)).has_value());
+
+    auto rowWords = SimulatedMeetingRoomScheduler::gridRowWords(start, start + days(10), minutes(15));
+    ASSERT_EQ(rowWords, 15);
+
+    std::vector<uint64_t> sequential(2 * rowWords), parallel(2 * rowWords, ~uint64_t(0));
+    EXPECT_EQ(scheduler.availabilityGrid(start, start + days(10), minutes(15), sequential), 2);
+    EXPECT_EQ(scheduler.availabilityGrid(start, start + days(10), minutes(15), parallel, 4), 2);
+
+    EXPECT_EQ(sequential, parallel);
+    EXPECT_NE(sequential[rowWords - 1], 0);
+}
+
+TEST(meeting_rooms, no_double_booking)
+{
+    MeetingRoomScheduler scheduler;
+
+    std::list<MeetingRoom> meetingRooms;
+    for (size_t i = 0; i < 3; i++)
+    {
+        meetingRooms.push_back({"#M" + std::to_string(i), i});
+        scheduler.registerRoom(meetingRooms.back());
+    }
+
+    auto slot = DateTimeSlot(system_clock::now() + hours(1), 60);
+    std::atomic<int> anyRoomBookings = 0, namedRoomBookings = 0;
+
+    auto requestRoom = [&]()
+    {
+        for (size_t i = 0; i < 100; i++)
+        {
+            if (scheduler.requestRoom("#M0", slot).has_value())
+                namedRoomBookings++;
+
+            if (scheduler.requestRoom(slot).has_value())
+                anyRoomBookings++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; i++)
+        threads.emplace_back(requestRoom);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    // Every room can be booked only once for the same slot
+    EXPECT_EQ(namedRoomBookings + anyRoomBookings, 3);
+}
+
+TEST(meeting_rooms, room_ids)
+{
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(sys_days(2023y / 11 / 28))};
+
+    auto m1 = scheduler.registerRoom({"M1", 4});
+    auto m2 = scheduler.registerRoom({"M2", 8});
+
+    EXPECT_EQ(m1, 0);
+    EXPECT_EQ(m2, 1);
+    EXPECT_EQ(scheduler.registerRoom({"M1", 4}), m1);
+    EXPECT_EQ(scheduler.getRoom(m2).getName(), "M2");
+
+    auto slot1 = DateTimeSlot(2023y / 11 / 28, 15u, 30u, 60u);
+
+    auto booking = scheduler.requestRoom("M2", slot1);
+    ASSERT_TRUE(booking.has_value());
+    EXPECT_EQ(booking->roomId, m2);
+
+    booking = scheduler.requestRoom(slot1);
+    ASSERT_TRUE(booking.has_value());
+    EXPECT_EQ(booking->roomId, m1);
+
+    EXPECT_FALSE(scheduler.requestRoom(slot1).has_value());
+}
+
+TEST(meeting_rooms, booking_across_days)
+{
+    // On virtual time, so that the slots are still to come when they are booked
+    SimulatedMeetingRoomScheduler scheduler{VirtualClock(sys_days(2023y / 11 / 28))};
+    scheduler.registerRoom({"M1", 4});
+
+    // Spans the shards of two days
+    auto lateSlot = DateTimeSlot(2023y / 11 / 28, 23u, 30u, 60u);
+    auto nextDaySlot = DateTimeSlot(2023y / 11 / 29, 0u, 15u, 15u);
+    auto sameDaySlot = DateTimeSlot(2023y / 11 / 28, 23u, 0u, 45u);
+
+    auto booking = scheduler.requestRoom("M1", lateSlot);
+    ASSERT_TRUE(booking.has_value());
+
+    EXPECT_FALSE(scheduler.requestRoom(nextDaySlot).has_value());
+    EXPECT_FALSE(scheduler.requestRoom("M1", sameDaySlot).has_value());
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(2023y / 11 / 28, 12u, 0u, 24 * 60u)).has_value());
+    EXPECT_TRUE(scheduler.requestRoom(DateTimeSlot(2023y / 11 / 29, 0u, 30u, 30u)).has_value());
+
+    scheduler.cancelBooking(booking.value());
+
+    EXPECT_TRUE(scheduler.requestRoom("M1", nextDaySlot).has_value());
+    EXPECT_TRUE(scheduler.requestRoom(sameDaySlot).has_value());
+}
+
+TEST(meeting_rooms, importBookings)
+{
+    MeetingRoomScheduler scheduler;
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    auto now = system_clock::now();
+
+    std::vector<MeetingRoomBooking> bookings;
+    for (int i = 0; i < 100; i++)
+        bookings.push_back({static_cast<RoomId>(i % 2), DateTimeSlot(now + hours(1) + minutes(30 * (i / 2)), 30)});
+
+    // Unregistered room
+    bookings.push_back({5, DateTimeSlot(now + hours(1), 30)});
+
+    EXPECT_EQ(scheduler.importBookings(bookings), 100);
+
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(now + hours(2), 30)).has_value());
+    EXPECT_FALSE(scheduler.requestRoom("M2", DateTimeSlot(now + hours(10), 60)).has_value());
+    EXPECT_TRUE(scheduler.requestRoom(DateTimeSlot(now + hours(30), 30)).has_value());
+}
+
+TEST(meeting_rooms, requestRooms)
+{
+    MeetingRoomScheduler scheduler;
+    scheduler.registerRoom({"M1", 4});
+    scheduler.registerRoom({"M2", 8});
+
+    auto now = system_clock::now() + hours(1);
+    ASSERT_TRUE(scheduler.requestRoom("M1", DateTimeSlot(now, 60)).has_value());
+
+    // Unsorted, overlapping each other and the stored booking, the last one spans two days
+    std::vector<DateTimeSlot> slots{DateTimeSlot(now + minutes(30), 60), DateTimeSlot(now, 30), DateTimeSlot(now + minutes(15), 30),
+                                    DateTimeSlot(now + minutes(60), 30), DateTimeSlot(now + minutes(90), 48 * 60)};
+
+    auto bookings = scheduler.requestRooms(slots);
+    ASSERT_EQ(bookings.size(), slots.size());
+
+    ASSERT_TRUE(bookings[1].has_value());
+    EXPECT_EQ(bookings[1]->roomId, 1);
+    EXPECT_FALSE(bookings[2].has_value());
+    ASSERT_TRUE(bookings[0].has_value());
+    EXPECT_EQ(bookings[0]->roomId, 1);
+    ASSERT_TRUE(bookings[3].has_value());
+    EXPECT_EQ(bookings[3]->roomId, 0);
+    EXPECT_TRUE(bookings[4].has_value());
+
+    EXPECT_FALSE(scheduler.requestRoom(DateTimeSlot(now + minutes(80), 20)).has_value());
+    EXPECT_FALSE(scheduler.requestRoom("M1", DateTimeSlot(now + hours(25), 20)).has_value());
+    EXPECT_TRUE(scheduler.requestRoom("M2", DateTimeSlot(now + hours(25), 20)).has_value());
+}
+
+TEST(meeting_rooms, stats)
+{
+    MeetingRoomScheduler scheduler;
+    scheduler.registerRoom({"M1", 4});
+
+    auto slot = DateTimeSlot(system_clock::now() + hours(1), 60);
+
+    auto booking = scheduler.requestRoom(slot);
+    ASSERT_TRUE(booking.has_value());
+    EXPECT_FALSE(scheduler.requestRoom("M1", slot).has_value());
+    EXPECT_FALSE(scheduler.isRoomAvailable("M1", slot));
+
+    std::thread([&]
+                { scheduler.cancelBooking(booking.value()); })
+        .join();
+
+    EXPECT_TRUE(scheduler.isRoomAvailable("M1", slot));
+    EXPECT_EQ(scheduler.requestRooms(std::vector<DateTimeSlot>{slot, slot}).size(), 2);
+
+    auto stats = scheduler.stats();
+    EXPECT_EQ(stats[SchedulerOp::Book].calls, 2);
+    EXPECT_EQ(stats[SchedulerOp::Book].succeeded, 1);
+    EXPECT_EQ(stats[SchedulerOp::Book].latency.getCount(), 2);
+    EXPECT_EQ(stats[SchedulerOp::Query].calls, 2);
+    EXPECT_EQ(stats[SchedulerOp::Query].succeeded, 1);
+    EXPECT_EQ(stats[SchedulerOp::Cancel].calls, 1);
+    EXPECT_EQ(stats[SchedulerOp::BookBatch].calls, 2);
+    EXPECT_EQ(stats[SchedulerOp::BookBatch].succeeded, 1);
+    EXPECT_EQ(stats[SchedulerOp::BookBatch].latency.getCount(), 1);
+    EXPECT_LE(stats[SchedulerOp::Book].latency.percentile(0.5), stats[SchedulerOp::Book].latency.percentile(0.999));
+}
+
+TEST(meeting_rooms, latency_histogram)
+{
+    LatencyHistogram histogram;
+
+    for (int64_t i = 1; i <= 1000; i++)
+        histogram.add(microseconds(i));
+
+    // Percentiles are bucket upper bounds, at most 12.5% above the exact value
+    EXPECT_GE(histogram.percentile(0.5), microseconds(500));
+    EXPECT_LE(histogram.percentile(0.5), microseconds(563));
+    EXPECT_GE(histogram.percentile(0.99), microseconds(990));
+    EXPECT_LE(histogram.percentile(0.99), microseconds(1114));
+    EXPECT_EQ(LatencyHistogram::bucketOf(5), 5);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+
+#include "../include/timing_wheel.hpp"
+
+TEST(timing_wheel, advance)
+{
+    TimingWheel<int> wheel(1000);
+
+    wheel.schedule(1005, 1);
+    wheel.schedule(1005, 2);
+    wheel.schedule(1070, 3);
+    wheel.schedule(5000, 4);
+    wheel.schedule(900, 5);
+
+    EXPECT_EQ(wheel.size(), 5);
+    EXPECT_EQ(wheel.nextExpiry(), 1000);
+
+    std::vector<int> expired;
+    auto collect = [&](int payload)
+    { expired.push_back(payload); };
+
+    EXPECT_EQ(wheel.advance(1000, collect), 1);
+    EXPECT_EQ(expired, std::vector<int>{5});
+
+    EXPECT_EQ(wheel.advance(1004, collect), 0);
+    EXPECT_EQ(wheel.advance(1069, collect), 2);
+    EXPECT_EQ(wheel.advance(1070, collect), 1);
+    EXPECT_EQ(wheel.size(), 1);
+
+    EXPECT_EQ(wheel.advance(100000, collect), 1);
+    EXPECT_EQ(expired.back(), 4);
+    EXPECT_FALSE(wheel.nextExpiry().has_value());
+}
+
+TEST(timing_wheel, cancel)
+{
+    TimingWheel<int> wheel;
+
+    auto id1 = wheel.schedule(10, 1);
+    wheel.schedule(10, 2);
+    auto id3 = wheel.schedule(1 << 20, 3);
+
+    wheel.cancel(id1);
+    wheel.cancel(id3);
+
+    std::vector<int> expired;
+    wheel.advance(int64_t(1) << 30, [&](int payload)
+                  { expired.push_back(payload); });
+
+    EXPECT_EQ(expired, std::vector<int>{2});
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(timing_wheel, random_deadlines)
+{
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<int64_t> deadlines(0, int64_t(1) << 40);
+
+    TimingWheel<int64_t> wheel;
+    std::multiset<int64_t> pending;
+
+    for (int i = 0; i < 20000; i++)
+    {
+        auto deadline = deadlines(gen);
+        wheel.schedule(deadline, deadline);
+        pending.insert(deadline);
+    }
+
+    // Every advance expires exactly the entries due by then
+    for (int64_t tick = 0; !pending.empty(); tick += int64_t(1) << 34)
+    {
+        wheel.advance(tick, [&](int64_t deadline)
+                      {
+                          EXPECT_LE(deadline, tick);
+                          pending.erase(pending.find(deadline)); });
+
+        EXPECT_TRUE(pending.empty() || *pending.begin() > tick);
+        EXPECT_EQ(wheel.size(), pending.size());
+    }
+}